@@ -1,13 +1,15 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 #include <sysexits.h>
 
+#include <chrono>
+
 #include "ns3/animation-interface.h"
 #include "ns3/aodv-helper.h"
 #include "ns3/command-line.h"
 #include "ns3/config.h"
 #include "ns3/core-module.h"
 #include "ns3/double.h"
-//#include "ns3/dsdv-helper.h"
+#include "ns3/dsdv-helper.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-interface-container.h"
@@ -18,6 +20,7 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/mobility-model.h"
 #include "ns3/netanim-module.h"
+#include "ns3/olsr-helper.h"
 #include "ns3/node-container.h"
 #include "ns3/nstime.h"
 #include "ns3/object.h"
@@ -33,6 +36,7 @@
 #include "simulation-params.h"
 #include "ns3/ecs-clustering.h"
 #include "ns3/ecs-stats.h"
+#include "ns3/neighbor-oracle.h"
 
 using namespace ns3;
 using namespace ecs;
@@ -120,9 +124,28 @@ main (int argc, char *argv[])
   NS_LOG_UNCOND("Setting up Internet stacks...");
   InternetStackHelper internet;
 
-  NS_LOG_DEBUG("Using AODV routing");
+  // the ECS apps read the neighbours of whichever protocol is installed here
   AodvHelper aodv;
-  internet.SetRoutingHelper(aodv);
+  DsdvHelper dsdv;
+  OlsrHelper olsr;
+  std::string routingAdapter;
+  switch (params.routingProtocol) {
+    case RoutingType::DSDV:
+      NS_LOG_DEBUG("Using DSDV routing");
+      internet.SetRoutingHelper(dsdv);
+      routingAdapter = "dsdv";
+      break;
+    case RoutingType::OLSR:
+      NS_LOG_DEBUG("Using OLSR routing");
+      internet.SetRoutingHelper(olsr);
+      routingAdapter = "olsr";
+      break;
+    default:
+      NS_LOG_DEBUG("Using AODV routing");
+      internet.SetRoutingHelper(aodv);
+      routingAdapter = "aodv";
+      break;
+  }
 
   internet.Install(allAdHocNodes);
   Ipv4AddressHelper adhocAddresses;
@@ -133,6 +156,25 @@ main (int argc, char *argv[])
   ecs.SetAttribute("NeighborhoodSize", UintegerValue(params.neighborhoodSize));
   ecs.SetAttribute("StandoffTime", TimeValue(params.standoffTime));
   ecs.SetAttribute("WaitTime", TimeValue(params.waitTime));
+  ecs.SetAttribute("RoutingAdapter", StringValue(routingAdapter));
+  ecs.SetAttribute("NeighborRefresh", EnumValue(static_cast<int>(params.eventRefresh ? ecsClusterApp::RefreshMode::EVENT : ecsClusterApp::RefreshMode::POLL)));
+  ecs.SetAttribute("InformationExpiry", EnumValue(params.lazyExpiry ? ecsClusterApp::EXPIRY_LAZY : ecsClusterApp::EXPIRY_SWEEP));
+  ecs.SetAttribute("DuplicateFilter", EnumValue(params.bloomDedupe ? ecsClusterApp::DEDUPE_BLOOM : ecsClusterApp::DEDUPE_WINDOW));
+  ecs.SetAttribute("FilterMemory", UintegerValue(params.filterMemory));
+  ecs.SetAttribute("WireFormat", EnumValue(params.binaryWireFormat ? ecsClusterApp::WIRE_BINARY : ecsClusterApp::WIRE_PROTOBUF));
+  ecs.SetAttribute("CoalesceWindow", TimeValue(params.coalesceWindow));
+  ecs.SetAttribute("PiggybackDelay", TimeValue(params.piggybackDelay));
+  ecs.SetAttribute("HelloScheduler", EnumValue(params.trickleHello ? ecsClusterApp::HELLO_TRICKLE : ecsClusterApp::HELLO_FIXED));
+  ecs.SetAttribute("TrickleImax", TimeValue(params.trickleImax));
+  ecs.SetAttribute("TrickleRedundancy", UintegerValue(params.trickleRedundancy));
+
+  if(params.neighborOracle) {
+    // the same range the RangePropagationLossModel above cuts the links at
+    Ptr<NeighborOracle> oracle = CreateObject<NeighborOracle>();
+    oracle->SetAttribute("Range", DoubleValue(params.wifiRadius));
+    oracle->Add(allAdHocNodes);
+    ecs.SetAttribute("NeighborOracle", PointerValue(oracle));
+  }
 
   ApplicationContainer ecsApps = ecs.Install(allAdHocNodes);
  
@@ -149,13 +191,19 @@ main (int argc, char *argv[])
 
   Simulator::Stop(params.runtime + 1.0_sec);
 
+  auto wallStart = std::chrono::steady_clock::now();
   Simulator::Run();
+  std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - wallStart;
   NS_LOG_UNCOND("test time @ " << Simulator::Now());
+  NS_LOG_UNCOND("Executed " << Simulator::GetEventCount() << " events in " << wallTime.count() << "s wall clock time");
   //std::cout << "test time @ " << Simulator::Now() << "\n";
   Simulator::Destroy();
   NS_LOG_UNCOND("Done.");
   //std::cout << "Done\n";
   stats.PrintMessageTotals();
+  // the stats were reset once the clusters had formed
+  stats.PrintAllocationRate((params.runtime - params.waitTime).GetSeconds());
+  stats.PrintControlRate((params.runtime - params.waitTime).GetSeconds(), params.totalNodes);
   stats.PrintClusterAverage(params.seed, params.nodeSpeed, params.totalNodes);
   //stats.WriteFinalStats(params.runtime.GetSeconds()-1, params.totalNodes, params.nodeSpeed, params.seed);
 
@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/// \file hello-scheduler-benchmark.cc
+/// \brief Compares the fixed one second hello against Trickle pacing in a
+///        neighbourhood where every node hears every other, for the hellos
+///        sent and for how well the neighbours' rows are kept.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "ns3/command-line.h"
+
+#include "ns3/adaptive-interval.h"
+#include "ns3/trickle-timer.h"
+
+using namespace ns3;
+
+// The app's defaults: a one second hello, rows kept for 2.3 seconds, a
+// Trickle from one to four seconds and no interval past four seconds counted
+// towards a row's validity
+static const double HELLO_INTERVAL = 1.0;
+static const double ENTRY_TIMEOUT = 2.3;
+static const double IMIN = 1.0;
+static const double IMAX = 4.0;
+
+// guard is what the app does, a hello is only suppressed while the last one
+// sent keeps this node's rows until the end of the next interval
+struct Config {
+  const char* name;
+  bool trickle;
+  uint32_t k;
+  double imax;
+  double maxValidInterval;
+  bool guard;
+};
+
+struct Result {
+  double hellosPerNodeSecond;
+  double dropsPerNodeMinute;
+  double coverage;
+};
+
+struct Event {
+  double time;
+  uint32_t node;
+  uint32_t generation;
+  bool endOfInterval;
+  bool operator>(const Event& other) const { return time > other.time; }
+};
+
+// One node of the neighbourhood, handled the way ecsClusterApp handles its
+// hellos: a row the sender was not in is a new neighbour and resets Trickle,
+// one that was is a consistent copy heard
+struct Sender {
+  ecs::TrickleTimer trickle;
+  double advertised;
+  double intervalEnd;
+  double coveredUntil;
+  uint32_t generation;
+  std::vector<double> validUntil;
+};
+
+static Result Run(const Config& config, uint32_t nodes, double warmup, double duration, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+  std::vector<Sender> node(nodes);
+  double end = warmup + duration;
+  uint64_t sent = 0;
+  uint64_t drops = 0;
+  double covered = 0;
+  uint32_t samples = 0;
+
+  auto startInterval = [&](uint32_t i, double now) {
+    double t = node[i].trickle.StartInterval(uniform(rng)).GetSeconds();
+    node[i].advertised = node[i].trickle.GetNextInterval().GetSeconds();
+    node[i].intervalEnd = now + node[i].trickle.GetInterval().GetSeconds();
+    events.push(Event{now + t, i, node[i].generation, false});
+    events.push(Event{now + node[i].trickle.GetInterval().GetSeconds(), i, node[i].generation, true});
+  };
+
+  for (uint32_t i = 0; i < nodes; i++) {
+    node[i].trickle = ecs::TrickleTimer(Seconds(IMIN), Seconds(config.imax), config.k);
+    node[i].advertised = HELLO_INTERVAL;
+    node[i].coveredUntil = -1;
+    node[i].generation = 0;
+    node[i].validUntil.assign(nodes, -1);
+    if (config.trickle) {
+      startInterval(i, uniform(rng));
+    } else {
+      events.push(Event{uniform(rng) * HELLO_INTERVAL, i, 0, false});
+    }
+  }
+
+  double nextSample = warmup;
+  while (!events.empty() && events.top().time < end) {
+    Event event = events.top();
+    events.pop();
+    double now = event.time;
+
+    // once a second, the share of neighbour rows that are held
+    for (; nextSample <= now; nextSample += 1.0) {
+      uint32_t held = 0;
+      for (uint32_t r = 0; r < nodes; r++) {
+        for (uint32_t s = 0; s < nodes; s++) held += r != s && node[r].validUntil[s] >= nextSample;
+      }
+      covered += (double)held / (nodes * (nodes - 1));
+      samples++;
+    }
+
+    Sender& sender = node[event.node];
+    if (event.generation != sender.generation) continue;
+    if (event.endOfInterval) {
+      sender.trickle.EndInterval();
+      startInterval(event.node, now);
+      continue;
+    }
+    if (!config.trickle) {
+      events.push(Event{now + HELLO_INTERVAL, event.node, 0, false});
+    } else if (!sender.trickle.ShouldSend() &&
+               (!config.guard || sender.intervalEnd + sender.trickle.GetNextInterval().GetSeconds() <= sender.coveredUntil)) {
+      continue;
+    }
+
+    if (now >= warmup) sent++;
+    Time valid = ecs::HelloValidity(Seconds(sender.advertised), Seconds(ENTRY_TIMEOUT),
+                                    Seconds(config.maxValidInterval));
+    sender.coveredUntil = now + valid.GetSeconds();
+    for (uint32_t r = 0; r < nodes; r++) {
+      if (r == event.node) continue;
+      Sender& receiver = node[r];
+      double& row = receiver.validUntil[event.node];
+      bool known = row >= now;
+      // a row that lapsed while its node was still there
+      if (!known && row >= 0 && now >= warmup) drops++;
+      row = now + valid.GetSeconds();
+
+      if (!config.trickle) continue;
+      if (known) {
+        receiver.trickle.Heard();
+      } else if (receiver.trickle.Reset()) {
+        receiver.generation++;
+        startInterval(r, now);
+      }
+    }
+  }
+
+  Result result;
+  result.hellosPerNodeSecond = sent / (nodes * duration);
+  result.dropsPerNodeMinute = drops * 60.0 / (nodes * duration);
+  result.coverage = samples > 0 ? covered / samples : 0;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  double warmup = 120;
+  double duration = 1200;
+  uint32_t runs = 5;
+
+  CommandLine cmd;
+  cmd.AddValue("warmup", "Seconds before anything is counted", warmup);
+  cmd.AddValue("duration", "Seconds counted after the warmup", duration);
+  cmd.AddValue("runs", "Seeds averaged for each configuration", runs);
+  cmd.Parse(argc, argv);
+
+  // the app's Trickle defaults last, the rest show what each part buys
+  const Config configs[] = {
+      {"fixed-1s", false, 0, 0, IMAX, false},
+      {"imax16-k0", true, 0, 16, 16, false},
+      {"imax16-k1", true, 1, 16, 16, false},
+      {"imax16-cap4-k0", true, 0, 16, IMAX, false},
+      {"imax4-k0", true, 0, IMAX, IMAX, false},
+      {"imax4-k1-unguarded", true, 1, IMAX, IMAX, false},
+      {"imax4-k2", true, 2, IMAX, IMAX, true},
+      {"imax4-k3", true, 3, IMAX, IMAX, true},
+      {"imax4-k1", true, 1, IMAX, IMAX, true},
+  };
+
+  std::cout << "config\tnodes\thellos_per_node_s\tdrops_per_node_min\trow_coverage\n";
+  for (uint32_t nodes : {5u, 20u}) {
+    for (const Config& config : configs) {
+      Result mean = {0, 0, 0};
+      for (uint32_t seed = 1; seed <= runs; seed++) {
+        Result result = Run(config, nodes, warmup, duration, seed);
+        mean.hellosPerNodeSecond += result.hellosPerNodeSecond / runs;
+        mean.dropsPerNodeMinute += result.dropsPerNodeMinute / runs;
+        mean.coverage += result.coverage / runs;
+      }
+      std::cout << config.name << "\t" << nodes << std::fixed << std::setprecision(3) << "\t"
+                << mean.hellosPerNodeSecond << "\t" << mean.dropsPerNodeMinute << "\t" << mean.coverage
+                << "\n";
+    }
+  }
+  return 0;
+}
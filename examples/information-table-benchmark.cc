@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/// \file information-table-benchmark.cc
+/// \brief Microbenchmark comparing the std::list information table the app
+///        used to keep against the column layout of InformationTable, for a
+///        census of the rows by status and for an expiry pass.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#include "ns3/command-line.h"
+
+#include "ns3/information-table.h"
+
+using namespace ns3;
+
+enum class Status { UNSPECIFIED, CLUSTER_HEAD, CLUSTER_MEMBER, CLUSTER_GATEWAY, STANDALONE, CLUSTER_GUEST };
+static const size_t STATUSES = 6;
+
+// same fields as ecsClusterApp::InformationTableRow
+struct Row {
+  uint32_t nodeID;
+  Status status;
+  uint32_t clusterHeadID;
+  uint32_t accessPointID;
+  double entryTime;
+  double validTime;
+};
+
+typedef ecs::InformationTable<Row, STATUSES> Table;
+
+static const double VALID_TIME = 2.3;
+
+// Rows last heard from evenly over the last VALID_TIME seconds, so a pass a
+// little after that finds the oldest few percent stale.
+static std::vector<Row> MakeRows(uint32_t count) {
+  std::vector<Row> rows;
+  uint32_t seed = 7;
+  for (uint32_t i = 0; i < count; i++) {
+    seed = seed * 1103515245 + 12345;
+    Row row;
+    row.nodeID = 0x0a010000 + i + 2;
+    row.status = (Status)((seed >> 16) % STATUSES);
+    row.clusterHeadID = 0;
+    row.accessPointID = 0;
+    row.entryTime = VALID_TIME * i / count;
+    row.validTime = VALID_TIME;
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+static void ListCensus(const std::list<Row>& table, double now, size_t counts[STATUSES]) {
+  std::fill(counts, counts + STATUSES, 0);
+  for (auto it = table.begin(); it != table.end(); ++it) {
+    if (now - it->entryTime <= it->validTime) counts[(size_t)it->status]++;
+  }
+}
+
+static size_t ListExpire(std::list<Row>& table, double now) {
+  size_t expired = 0;
+  for (auto it = table.begin(); it != table.end();) {
+    if (now - it->entryTime > it->validTime) {
+      it = table.erase(it);
+      expired++;
+    } else {
+      ++it;
+    }
+  }
+  return expired;
+}
+
+template <typename F>
+static double Nanoseconds(F pass) {
+  auto start = std::chrono::steady_clock::now();
+  pass();
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t iterations = 200;
+  double stale = 0.05;
+
+  CommandLine cmd;
+  cmd.AddValue("iterations", "Number of times each pass is run", iterations);
+  cmd.AddValue("stale", "Fraction of the rows that are stale at each expiry pass", stale);
+  cmd.Parse(argc, argv);
+
+  double now = VALID_TIME * (1 + stale) + 0.0005;
+
+  std::cout << "rows\tcensus_list_ns\tcensus_soa_ns\texpire_list_ns\tsweep_soa_ns\texpire_wheel_ns\n";
+  for (uint32_t count : {100u, 1000u, 10000u}) {
+    std::vector<Row> rows = MakeRows(count);
+
+    std::list<Row> list(rows.begin(), rows.end());
+    Table table;
+    for (const Row& row : rows) table.Upsert(row);
+
+    size_t listCounts[STATUSES];
+    size_t soaCounts[STATUSES];
+    ListCensus(list, now, listCounts);
+    table.Census(now, soaCounts);
+    if (!std::equal(listCounts, listCounts + STATUSES, soaCounts)) {
+      std::cerr << "census disagrees on " << count << " rows\n";
+      return 1;
+    }
+
+    volatile size_t sink = 0;
+    double censusList = 0;
+    double censusSoa = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+      censusList += Nanoseconds([&]() {
+        ListCensus(list, now, listCounts);
+        sink += listCounts[1];
+      });
+      censusSoa += Nanoseconds([&]() {
+        table.Census(now, soaCounts);
+        sink += soaCounts[1];
+      });
+    }
+
+    // every expiry pass starts from a fresh copy, only the pass is timed
+    double expireList = 0;
+    double sweepSoa = 0;
+    double expireWheel = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+      std::list<Row> listCopy(rows.begin(), rows.end());
+      Table sweepCopy;
+      Table wheelCopy;
+      for (const Row& row : rows) {
+        sweepCopy.Upsert(row);
+        wheelCopy.Upsert(row);
+      }
+
+      size_t listExpired = 0;
+      size_t sweepExpired = 0;
+      size_t wheelExpired = 0;
+      expireList += Nanoseconds([&]() { listExpired = ListExpire(listCopy, now); });
+      sweepSoa += Nanoseconds([&]() { sweepExpired = sweepCopy.Sweep(now); });
+      expireWheel += Nanoseconds([&]() { wheelExpired = wheelCopy.Expire(now); });
+      if (listExpired != sweepExpired || listExpired != wheelExpired) {
+        std::cerr << "expiry disagrees on " << count << " rows\n";
+        return 1;
+      }
+      sink += listExpired;
+    }
+
+    std::cout << count << std::fixed << std::setprecision(0) << "\t" << censusList / iterations
+              << "\t" << censusSoa / iterations << "\t" << expireList / iterations << "\t"
+              << sweepSoa / iterations << "\t" << expireWheel / iterations << "\n";
+  }
+
+  return 0;
+}
@@ -65,6 +65,24 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
 
   double optRequestTimeout = 0.0_seconds; //sets to 0 to ignore timeouts
 
+  // Neighbourhood refresh, "poll" or "event"
+  std::string optRefreshMode = "poll";
+  // Where neighbourhoods come from, "routing" or "oracle"
+  std::string optNeighbors = "routing";
+  std::string optExpiry = "sweep";
+  // How duplicate messages are recognised, "window" or "bloom"
+  std::string optDedupe = "window";
+  uint32_t optFilterMemory = 4096;
+  // How messages are encoded, "protobuf" or "binary"
+  std::string optWireFormat = "protobuf";
+  // Outbound coalescing, 0 sends every message at once
+  double optCoalesceWindow = 0.0_seconds;
+  double optPiggybackDelay = 0.0_seconds;
+  // How hellos are paced, "fixed" or "trickle"
+  std::string optHello = "fixed";
+  double optTrickleImax = 4.0_seconds;
+  uint32_t optTrickleRedundancy = 1;
+
   // Animation parameters.
   std::string animationTraceFilePath = "ecs.xml";
   /* Setup commandline option for each simulation parameter. */
@@ -101,8 +119,19 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
       "requestTimeout",
       "The number of seconds to wait before marking a lookup as failed",
       optRequestTimeout);
-  cmd.AddValue("routing", "One of either 'DSDV' or 'AODV'", optRoutingProtocol);
+  cmd.AddValue("routing", "One of 'DSDV', 'AODV' or 'OLSR'", optRoutingProtocol);
   cmd.AddValue("wifiRadius", "The radius of connectivity for each node in meters", optWifiRadius);
+  cmd.AddValue("refreshMode", "Refresh the neighbourhood by 'poll' or on 'event'", optRefreshMode);
+  cmd.AddValue("neighbors", "Read neighbourhoods from the 'routing' table or a position 'oracle'", optNeighbors);
+  cmd.AddValue("expiry", "Drop stale information table rows by 'sweep' or 'lazy' on read", optExpiry);
+  cmd.AddValue("dedupe", "Recognise duplicate messages with a per sender 'window' or a 'bloom' filter", optDedupe);
+  cmd.AddValue("filterMemory", "Bytes per node for the bloom duplicate filter", optFilterMemory);
+  cmd.AddValue("wireFormat", "Encode messages as 'protobuf' or the fixed layout 'binary' header", optWireFormat);
+  cmd.AddValue("coalesceWindow", "Seconds messages to the same destination are held to share a frame", optCoalesceWindow);
+  cmd.AddValue("piggybackDelay", "Seconds a status reply may wait to ride along with the next hello", optPiggybackDelay);
+  cmd.AddValue("hello", "Send hellos at a 'fixed' interval or pace them with a 'trickle' timer", optHello);
+  cmd.AddValue("trickleImax", "Seconds the trickle hello interval may double up to", optTrickleImax);
+  cmd.AddValue("trickleK", "Consistent hellos heard that suppress a node's own, 0 never suppresses", optTrickleRedundancy);
   cmd.AddValue("standoffTime", "The max time for nodes to sleep (they are given a random from 0 to this)", optStandoffTime);
   //cmd.AddValue("nodeSpeed", "The speed at which nodes are moving, for stats purposes", optNodeSpeed);
   // cmd.AddValue("animationXml", "Output file path for NetAnim trace file",
@@ -166,6 +195,36 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
     return std::pair<SimulationParameters, bool>(result, false);
   }
 
+  if(optRefreshMode != "poll" && optRefreshMode != "event") {
+    std::cerr << "Unrecognized refresh mode '" + optRefreshMode + "'." << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+
+  if(optNeighbors != "routing" && optNeighbors != "oracle") {
+    std::cerr << "Unrecognized neighbor source '" + optNeighbors + "'." << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+
+  if(optExpiry != "sweep" && optExpiry != "lazy") {
+    std::cerr << "Unrecognized expiry mode '" + optExpiry + "'." << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+
+  if(optDedupe != "window" && optDedupe != "bloom") {
+    std::cerr << "Unrecognized dedupe mode '" + optDedupe + "'." << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+
+  if(optWireFormat != "protobuf" && optWireFormat != "binary") {
+    std::cerr << "Unrecognized wire format '" + optWireFormat + "'." << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+
+  if(optHello != "fixed" && optHello != "trickle") {
+    std::cerr << "Unrecognized hello scheduler '" + optHello + "'." << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+
   Ptr<ConstantRandomVariable> travellerVelocityGenerator = CreateObject<ConstantRandomVariable>();
   travellerVelocityGenerator->SetAttribute("Constant", DoubleValue(optTravellerVelocity));
 
@@ -206,6 +265,17 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
 
   result.routingProtocol = routingType;
   result.wifiRadius = optWifiRadius;
+  result.eventRefresh = optRefreshMode == "event";
+  result.neighborOracle = optNeighbors == "oracle";
+  result.lazyExpiry = optExpiry == "lazy";
+  result.bloomDedupe = optDedupe == "bloom";
+  result.filterMemory = optFilterMemory;
+  result.binaryWireFormat = optWireFormat == "binary";
+  result.coalesceWindow = Seconds(optCoalesceWindow);
+  result.piggybackDelay = Seconds(optPiggybackDelay);
+  result.trickleHello = optHello == "trickle";
+  result.trickleImax = Seconds(optTrickleImax);
+  result.trickleRedundancy = optTrickleRedundancy;
 
   result.netanimTraceFilePath = animationTraceFilePath;
 
@@ -76,6 +76,33 @@ class SimulationParameters {
     ns3::Time pbnVelocityChangePeriod;
     /// Indicates the type of routing to use for the simulation.
     ecs::RoutingType routingProtocol;
+    /// Whether the apps poll their neighbourhood or refresh it on change.
+    bool eventRefresh;
+    /// Whether neighbourhoods come from a shared position oracle instead of
+    /// each node's routing table.
+    bool neighborOracle;
+    /// Whether stale information table rows are skipped on read instead of
+    /// being swept on every refresh.
+    bool lazyExpiry;
+    /// Whether duplicate messages are recognised with a fixed size Bloom
+    /// filter instead of an exact window per sender.
+    bool bloomDedupe;
+    /// Bytes each node spends on the Bloom duplicate filter.
+    uint32_t filterMemory;
+    /// Whether messages are encoded with the fixed layout EcsHeader instead
+    /// of protobuf.
+    bool binaryWireFormat;
+    /// How long messages to the same destination are held to share a frame.
+    ns3::Time coalesceWindow;
+    /// How long a status reply may wait to ride along with the next hello.
+    ns3::Time piggybackDelay;
+    /// Whether hellos are paced with a Trickle timer instead of a fixed
+    /// interval.
+    bool trickleHello;
+    /// The longest interval the Trickle timer doubles up to.
+    ns3::Time trickleImax;
+    /// How many consistent hellos heard suppress a node's own, 0 for never.
+    uint32_t trickleRedundancy;
     /// The radius of connectivity for each node.
     double wifiRadius;
     /// The path on disk to output the NetAnim trace XML file for visualizing the
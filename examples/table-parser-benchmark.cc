@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/// \file table-parser-benchmark.cc
+/// \brief Microbenchmark comparing the original split/trim/tokenize routing
+///        table parser against the single pass Table::GetNeighbors on
+///        synthetic AODV routing table dumps.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/command-line.h"
+#include "ns3/ipv4-address.h"
+
+#include "ns3/table.h"
+
+using namespace ns3;
+
+namespace legacy {
+
+// The AODV path of the parser Table::GetNeighbors used before it was rewritten,
+// kept as the baseline for the comparison.
+
+static std::vector<std::string> split(const std::string str, char seprater) {
+  std::vector<std::string> list;
+  std::string tmp = str;
+
+  size_t last = 0;
+  size_t pos = 0;
+
+  while ((pos = tmp.find(seprater, last)) != std::string::npos) {
+    list.push_back(tmp.substr(last, (pos - last)));
+    last = pos + 1;
+  }
+
+  return list;
+}
+
+static std::string trim(const std::string str) {
+  std::string tmp = str;
+  tmp.erase(tmp.find_last_not_of(" \n\r\t") + 1);
+  tmp.erase(0, tmp.find_first_not_of(" \n\r\t"));
+
+  return tmp;
+}
+
+static std::vector<std::string> trimStrings(const std::vector<std::string> strings) {
+  std::vector<std::string> list;
+
+  for (auto it = strings.begin(); it != strings.end(); ++it) {
+    list.push_back(trim(*it));
+  }
+
+  return list;
+}
+
+static std::vector<std::string> filterStrings(const std::vector<std::string> strings) {
+  std::vector<std::string> list;
+
+  for (auto it = strings.begin(); it != strings.end(); ++it) {
+    if ((*it).empty() || !isdigit((*it)[0])) {
+      continue;
+    }
+    list.push_back((*it));
+  }
+
+  return list;
+}
+
+static std::vector<std::string> tokenize(const std::string str) {
+  std::istringstream iss(str);
+  std::vector<std::string> tokens;
+
+  for (std::string s; iss >> s;) {
+    tokens.push_back(s);
+  }
+
+  return tokens;
+}
+
+static bool isLoopback(const std::string address) { return address == "127.0.0.1"; }
+
+static bool isBroadcast(const std::string address) {
+  return address.find(".255.255") != std::string::npos;
+}
+
+static std::vector<std::string> getAodvDestinations(
+    const std::vector<std::string> enteries,
+    uint32_t maxHops) {
+  std::vector<std::string> list;
+
+  for (auto entry : enteries) {
+    std::vector<std::string> parts = tokenize(entry);
+
+    uint32_t hops = (uint32_t)std::stoi(parts[5], nullptr, 10);
+
+    if (parts[3] != "UP") continue;
+    if (isLoopback(parts[0]) || isBroadcast(parts[0])) continue;
+    if (hops <= 0 || hops > maxHops) continue;
+
+    list.push_back(parts[0]);
+  }
+
+  return list;
+}
+
+static std::set<uint32_t> GetNeighbors(const std::string table, uint32_t maxHops) {
+  std::vector<std::string> parts = split(table, '\n');
+  std::vector<std::string> trimmed = trimStrings(parts);
+  std::vector<std::string> filtered = filterStrings(trimmed);
+
+  std::vector<std::string> destinations = getAodvDestinations(filtered, maxHops);
+
+  std::set<uint32_t> neighbors;
+  for (auto entry : destinations) {
+    neighbors.insert(Ipv4Address(entry.c_str()).Get());
+  }
+  return neighbors;
+}
+
+}  // namespace legacy
+
+// Build a dump in the same shape as aodv::RoutingProtocol::PrintRoutingTable,
+// a mix of UP/DOWN routes with 1 to 4 hops plus the loopback and broadcast routes.
+static std::string MakeAodvDump(uint32_t entries) {
+  std::ostringstream ss;
+  ss << "Node: 0; Time: +100s, Local time: +100s, AODV Routing table\n";
+  ss << "\nAODV Routing table\n";
+  ss << "Destination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n";
+  ss << "10.1.255.255\t10.1.255.255\t10.1.0.1\tUP\t+9223372036.85s\t\t1\n";
+  for (uint32_t i = 0; i < entries; i++) {
+    uint32_t host = i + 2;
+    std::string dest = "10.1." + std::to_string(host / 256) + "." + std::to_string(host % 256);
+    ss << dest << "\t" << dest << "\t10.1.0.1\t" << (i % 7 == 0 ? "DOWN" : "UP") << "\t+"
+       << std::fixed << std::setprecision(2) << (1.0 + (i % 300) / 100.0) << "s\t\t"
+       << (1 + i % 4) << "\n";
+  }
+  ss << "127.0.0.1\t127.0.0.1\t127.0.0.1\tUP\t+9223372036.85s\t\t1\n";
+  ss << "\n";
+  return ss.str();
+}
+
+// the best of several timed runs, a single run is too easily disturbed by
+// whatever else the machine is doing
+template <typename F>
+static double LinesPerSecond(uint32_t lines, uint32_t iterations, uint32_t repeats, F parse) {
+  double best = 0;
+  for (uint32_t r = 0; r < repeats; r++) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+      parse();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::max(best, (double)lines * iterations / elapsed.count());
+  }
+  return best;
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t iterations = 200;
+  uint32_t repeats = 5;
+  uint32_t maxHops = 1;
+  // the dumps are of a 10.1.0.0/16 network
+  uint32_t mask = Ipv4Mask("255.255.0.0").Get();
+
+  CommandLine cmd;
+  cmd.AddValue("iterations", "Number of times each dump is parsed", iterations);
+  cmd.AddValue("repeats", "Number of timed runs, the fastest is reported", repeats);
+  cmd.AddValue("hops", "The number of hops to consider in the neighborhood of a node", maxHops);
+  cmd.Parse(argc, argv);
+
+  std::cout << "entries\tlegacy_lines_per_s\tstreaming_lines_per_s\tspeedup\n";
+  for (uint32_t entries : {100u, 1000u, 5000u}) {
+    std::string dump = MakeAodvDump(entries);
+    uint32_t lines = entries + 6;
+
+    std::vector<uint32_t> scratch;
+    ecs::Table::GetNeighbors(dump, mask, maxHops, scratch);
+    std::set<uint32_t> expected = legacy::GetNeighbors(dump, maxHops);
+    if (std::set<uint32_t>(scratch.begin(), scratch.end()) != expected) {
+      std::cerr << "parsers disagree on the " << entries << " entry dump\n";
+      return 1;
+    }
+
+    volatile size_t sink = 0;
+    double before = LinesPerSecond(lines, iterations, repeats, [&]() {
+      sink += legacy::GetNeighbors(dump, maxHops).size();
+    });
+    double after = LinesPerSecond(lines, iterations, repeats, [&]() {
+      ecs::Table::GetNeighbors(dump, mask, maxHops, scratch);
+      sink += scratch.size();
+    });
+
+    std::cout << entries << "\t" << std::fixed << std::setprecision(0) << before << "\t" << after
+              << "\t" << std::setprecision(1) << after / before << "x\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/// \file wire-format-benchmark.cc
+/// \brief Microbenchmark comparing the protobuf encoding of the ECS messages
+///        against the fixed layout EcsHeader, for the size on the wire and
+///        the time to encode into and decode out of a packet.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ns3/command-line.h"
+#include "ns3/packet.h"
+
+#include "ns3/ecs-header.h"
+#include "ns3/replay-window.h"
+
+#include "proto/messages.pb.h"
+
+using namespace ns3;
+
+struct Sample {
+  std::string name;
+  ecs::EcsHeader header;
+};
+
+// The messages a node sends most, as ecsClusterApp builds them
+static std::vector<Sample> MakeSamples() {
+  std::vector<Sample> samples;
+  uint64_t id = ecs::MakeMessageId(0x0a010001, 4242);
+
+  for (uint32_t heads : {0u, 1u, 3u}) {
+    Sample ping;
+    ping.name = "ping/" + std::to_string(heads);
+    ping.header.SetType(ecs::EcsHeader::PING);
+    ping.header.SetHelloInterval(1000);
+    for (uint32_t h = 0; h < heads; h++) ping.header.AddHead(0x0a010010 + h);
+    samples.push_back(ping);
+  }
+
+  Sample status;
+  status.name = "status/1";
+  status.header.SetType(ecs::EcsHeader::STATUS);
+  status.header.AddHead(0x0a010010);
+  samples.push_back(status);
+
+  Sample claim;
+  claim.name = "claim";
+  claim.header.SetType(ecs::EcsHeader::CLAIM);
+  samples.push_back(claim);
+
+  Sample meeting;
+  meeting.name = "meeting";
+  meeting.header.SetType(ecs::EcsHeader::MEETING);
+  meeting.header.SetTableSize(12);
+  samples.push_back(meeting);
+
+  for (Sample& sample : samples) {
+    sample.header.SetId(id++);
+    sample.header.SetTimestamp(312345);
+    sample.header.SetNodeStatus(2);
+  }
+  return samples;
+}
+
+static void ToMessage(const ecs::EcsHeader& header, ecs::packets::Message& message) {
+  message.set_id(header.GetId());
+  message.set_timestamp(header.GetTimestamp());
+  message.set_node_status(header.GetNodeStatus());
+  switch (header.GetType()) {
+    case ecs::EcsHeader::PING:
+      message.mutable_ping()->set_hello_interval(header.GetHelloInterval());
+      for (size_t h = 0; h < header.GetNumHeads(); h++) message.mutable_ping()->add_heads(header.GetHeads()[h]);
+      break;
+    case ecs::EcsHeader::STATUS:
+      for (size_t h = 0; h < header.GetNumHeads(); h++) message.mutable_status()->add_heads(header.GetHeads()[h]);
+      break;
+    case ecs::EcsHeader::CLAIM:
+      message.mutable_claim();
+      break;
+    case ecs::EcsHeader::MEETING:
+      message.mutable_meeting()->set_tablesize(header.GetTableSize());
+      break;
+    default:
+      break;
+  }
+}
+
+template <typename F>
+static double NanosecondsEach(uint32_t iterations, F pass) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    pass();
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t iterations = 100000;
+
+  CommandLine cmd;
+  cmd.AddValue("iterations", "Number of times each message is encoded and decoded", iterations);
+  cmd.Parse(argc, argv);
+
+  std::cout << "message\tprotobuf_bytes\tbinary_bytes\tprotobuf_ns\tbinary_ns\n";
+  for (const Sample& sample : MakeSamples()) {
+    ecs::packets::Message message;
+    ToMessage(sample.header, message);
+    std::vector<uint8_t> scratch(message.ByteSizeLong());
+
+    volatile uint64_t sink = 0;
+
+    // the same steps GeneratePacket and ParsePacket take
+    double protobuf = NanosecondsEach(iterations, [&]() {
+      size_t size = message.ByteSizeLong();
+      message.SerializeWithCachedSizesToArray(scratch.data());
+      Ptr<Packet> packet = Create<Packet>(scratch.data(), size);
+
+      ecs::packets::Message received;
+      packet->CopyData(scratch.data(), packet->GetSize());
+      received.ParseFromArray(scratch.data(), packet->GetSize());
+      sink += received.id();
+    });
+
+    double binary = NanosecondsEach(iterations, [&]() {
+      Ptr<Packet> packet = Create<Packet>();
+      packet->AddHeader(sample.header);
+
+      ecs::EcsHeader received;
+      packet->RemoveHeader(received);
+      sink += received.GetId();
+    });
+
+    std::cout << sample.name << "\t" << message.ByteSizeLong() << "\t"
+              << sample.header.GetSerializedSize() << std::fixed << std::setprecision(0) << "\t"
+              << protobuf << "\t" << binary << "\n";
+  }
+
+  google::protobuf::ShutdownProtobufLibrary();
+  return 0;
+}
@@ -0,0 +1,51 @@
+/// \file adaptive-interval.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "adaptive-interval.h"
+
+#include <algorithm>
+
+namespace ecs {
+
+AdaptiveInterval::AdaptiveInterval() : AdaptiveInterval(Seconds(1), Seconds(1), 1, 0, 1) {}
+
+AdaptiveInterval::AdaptiveInterval(Time min, Time max, double alpha, double low, double high)
+    : m_min(min), m_max(std::max(min, max)), m_alpha(alpha), m_low(low), m_high(high) {
+  m_interval = m_min;
+  m_smoothed = 0;
+}
+
+Time AdaptiveInterval::Update(double changeDegree) {
+  m_smoothed = m_alpha * changeDegree + (1 - m_alpha) * m_smoothed;
+
+  if (changeDegree > m_high) {
+    // the smoothed value lags behind, react to a spike as soon as it is seen
+    m_interval = m_min;
+  } else if (m_smoothed < m_low) {
+    m_interval = std::min(m_interval + m_interval, m_max);
+  }
+
+  return m_interval;
+}
+
+// default entry timeout over the default hello interval
+static const double VALID_HELLO_MULTIPLE = 2.3;
+
+Time HelloValidity(Time helloInterval, Time timeout, Time maxInterval) {
+  Time interval = std::min(helloInterval, maxInterval);
+  return std::max(timeout, Seconds(VALID_HELLO_MULTIPLE * interval.GetSeconds()));
+}
+
+}  // namespace ecs
@@ -0,0 +1,61 @@
+/// \file adaptive-interval.h
+/// \brief Timer period that follows how fast the neighbourhood is changing.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_ADAPTIVE_INTERVAL_H
+#define __ECS_ADAPTIVE_INTERVAL_H
+
+#include "ns3/nstime.h"
+
+namespace ecs {
+
+using namespace ns3;
+
+/// \brief Keeps an exponentially smoothed neighbourhood change degree and
+///     derives a timer period from it. While the smoothed degree stays below
+///     the low threshold the period doubles up to the maximum, a sample above
+///     the high threshold drops it straight back to the minimum so a burst of
+///     movement is picked up on the next tick.
+class AdaptiveInterval {
+ public:
+  AdaptiveInterval();
+  AdaptiveInterval(Time min, Time max, double alpha, double low, double high);
+
+  /// \brief Feed the latest change degree, returns the period to use next.
+  Time Update(double changeDegree);
+
+  Time Get() const { return m_interval; }
+  double GetSmoothed() const { return m_smoothed; }
+
+ private:
+  Time m_min;
+  Time m_max;
+  double m_alpha;
+  double m_low;
+  double m_high;
+
+  Time m_interval;
+  double m_smoothed;
+};
+
+/// \brief How long to keep a neighbour that advertised helloInterval: timeout,
+///     or 2.3 of its intervals (the default timeout over the default interval)
+///     once it has stretched them further. Intervals past maxInterval count
+///     as maxInterval, so a neighbour that goes quiet is not kept for long.
+Time HelloValidity(Time helloInterval, Time timeout, Time maxInterval);
+
+}  // namespace ecs
+
+#endif
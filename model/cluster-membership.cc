@@ -0,0 +1,73 @@
+/// \file cluster-membership.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "cluster-membership.h"
+
+namespace ecs {
+
+ClusterMembership::ClusterMembership() : m_joinTimeSum(0) {}
+
+void ClusterMembership::Update(
+    uint32_t nodeID,
+    uint32_t head,
+    const uint32_t* heads,
+    size_t numHeads,
+    double now,
+    double validTime) {
+  Member member;
+  member.nodeID = nodeID;
+  member.entryTime = now;
+  member.validTime = validTime;
+  member.numOtherHeads = 0;
+  for (size_t i = 0; i < numHeads && member.numOtherHeads < MAX_OTHER_HEADS; i++) {
+    if (heads[i] != head) member.otherHeads[member.numOtherHeads++] = heads[i];
+  }
+  member.status = member.numOtherHeads > 0 ? GATEWAY : MEMBER;
+
+  // a member heard from again after it went stale but before it was expired
+  // has rejoined rather than stayed
+  const Member* current = m_members.Find(nodeID);
+  if (current != nullptr && now <= current->entryTime + current->validTime) {
+    member.joinTime = current->joinTime;
+  } else {
+    if (current != nullptr) m_joinTimeSum -= current->joinTime;
+    member.joinTime = now;
+    m_joinTimeSum += now;
+  }
+  m_members.Upsert(member);
+}
+
+bool ClusterMembership::Leave(uint32_t nodeID) {
+  const Member* current = m_members.Find(nodeID);
+  if (current == nullptr) return false;
+  m_joinTimeSum -= current->joinTime;
+  return m_members.Erase(nodeID);
+}
+
+size_t ClusterMembership::Expire(double now) {
+  return m_members.Expire(now, [this](const Member& member) { m_joinTimeSum -= member.joinTime; });
+}
+
+void ClusterMembership::Clear() {
+  m_members.Clear();
+  m_joinTimeSum = 0;
+}
+
+double ClusterMembership::GetMeanTenure(double now) {
+  size_t size = m_members.size();
+  return size == 0 ? 0 : now - m_joinTimeSum / size;
+}
+
+}  // namespace ecs
@@ -0,0 +1,90 @@
+/// \file cluster-membership.h
+/// \brief Members of the cluster a cluster head leads.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_CLUSTER_MEMBERSHIP_H
+#define __ECS_CLUSTER_MEMBERSHIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "information-table.h"
+
+namespace ecs {
+
+/// \brief The members and gateways of a cluster head's cluster, with when
+///     each joined, when it was last heard from and, for a gateway, which
+///     other heads it also serves. Kept by the head from the Ping and Status
+///     messages its members send, so the cluster size is a count rather than
+///     a filter over everything in the information table.
+class ClusterMembership {
+ public:
+  enum Role { MEMBER, GATEWAY, ROLES };
+
+  /// \brief Other heads kept for a gateway, any beyond this are dropped.
+  static const size_t MAX_OTHER_HEADS = 4;
+
+  struct Member {
+    uint32_t nodeID;
+    Role status;
+    double joinTime;
+    // last heard from, named so the table can expire it
+    double entryTime;
+    double validTime;
+    uint8_t numOtherHeads;
+    uint32_t otherHeads[MAX_OTHER_HEADS];
+  };
+
+  typedef InformationTable<Member, ROLES> Table;
+
+  ClusterMembership();
+
+  /// \brief nodeID was heard from at now and names head among its cluster
+  ///     heads, heads being every head it named. It joins when it is not
+  ///     already a member, and is a gateway when it named other heads too.
+  void Update(uint32_t nodeID, uint32_t head, const uint32_t* heads, size_t numHeads,
+              double now, double validTime);
+
+  /// \brief nodeID has left the cluster, false when it was not a member.
+  bool Leave(uint32_t nodeID);
+
+  /// \brief Drop the members not heard from within their validTime.
+  size_t Expire(double now);
+
+  void Clear();
+
+  const Member* Find(uint32_t nodeID) { return m_members.Find(nodeID); }
+
+  /// \brief Members and gateways, the head itself is not counted.
+  size_t GetSize() { return m_members.size(); }
+  size_t GetNumGateways() { return m_members.Count(GATEWAY); }
+
+  /// \brief Average time the current members have been in the cluster.
+  double GetMeanTenure(double now);
+
+  /// \brief Walk every member, or only those in one role.
+  Table::iterator begin() { return m_members.begin(); }
+  Table::iterator begin(Role role) { return m_members.begin(role); }
+  Table::iterator end() { return m_members.end(); }
+
+ private:
+  Table m_members;
+  // kept with every join and leave so the mean tenure is O(1)
+  double m_joinTimeSum;
+};
+
+}  // namespace ecs
+
+#endif
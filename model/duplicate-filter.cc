@@ -0,0 +1,124 @@
+/// \file duplicate-filter.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "duplicate-filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ecs {
+
+// splitmix64 finalizer, ids only differ in a few low bits so they need mixing
+static uint64_t Mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+DuplicateFilter::DuplicateFilter() : DuplicateFilter(4096, 0.001, 1) {}
+
+DuplicateFilter::DuplicateFilter(size_t memory, double falsePositiveRate, double period)
+    : m_period(period), m_falseDrops(0) {
+  m_words = std::max<size_t>(1, memory / sizeof(uint64_t) / 2);
+  m_bits.assign(2 * m_words, 0);
+
+  // a query looks in both generations, so each gets half of the target
+  double bits = 64.0 * m_words;
+  double rate = std::min(std::max(falsePositiveRate / 2, 1e-12), 0.5);
+  double ln2 = std::log(2.0);
+  m_capacity = std::max<size_t>(1, (size_t)(bits * ln2 * ln2 / -std::log(rate)));
+  m_hashes = std::max<size_t>(1, (size_t)std::lround(bits / m_capacity * ln2));
+
+  m_current = 0;
+  m_inserted = 0;
+  m_setBits[0] = m_setBits[1] = 0;
+  m_started = 0;
+}
+
+bool DuplicateFilter::CheckDuplicate(uint64_t id, double now) {
+  if (m_inserted >= m_capacity || now - m_started >= m_period) Rotate(now);
+
+  uint64_t hash = Mix(id);
+  if (Contains(m_current, hash)) return true;
+  bool duplicate = Contains(m_current ^ 1, hash);
+
+  if (!duplicate) {
+    // every new message had this chance of being dropped instead, and a new
+    // message is the only thing that can be dropped falsely
+    double rate = GetFalsePositiveRate();
+    m_falseDrops += rate / (1 - rate);
+  }
+
+  // an id still arriving is copied forward so it outlives the old generation
+  Insert(m_current, hash);
+  return duplicate;
+}
+
+void DuplicateFilter::Clear() {
+  std::fill(m_bits.begin(), m_bits.end(), 0);
+  m_inserted = 0;
+  m_setBits[0] = m_setBits[1] = 0;
+  m_falseDrops = 0;
+}
+
+double DuplicateFilter::GetOccupancy() const {
+  return (double)m_setBits[m_current] / (64.0 * m_words);
+}
+
+double DuplicateFilter::GetFalsePositiveRate() const {
+  double current = std::pow(GetOccupancy(), (double)m_hashes);
+  double old = std::pow((double)m_setBits[m_current ^ 1] / (64.0 * m_words), (double)m_hashes);
+  return 1 - (1 - current) * (1 - old);
+}
+
+// Kirsch-Mitzenmacher double hashing, the halves of one mixed hash give every
+// probe, mapped onto the bit array by a multiply instead of a modulo
+bool DuplicateFilter::Contains(size_t generation, uint64_t hash) const {
+  const uint64_t* bits = m_bits.data() + generation * m_words;
+  uint64_t size = 64 * m_words;
+  uint32_t h1 = (uint32_t)hash;
+  uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+
+  for (size_t i = 0; i < m_hashes; i++) {
+    uint64_t bit = (uint64_t)(uint32_t)(h1 + i * h2) * size >> 32;
+    if ((bits[bit / 64] & (uint64_t)1 << bit % 64) == 0) return false;
+  }
+  return true;
+}
+
+void DuplicateFilter::Insert(size_t generation, uint64_t hash) {
+  uint64_t* bits = m_bits.data() + generation * m_words;
+  uint64_t size = 64 * m_words;
+  uint32_t h1 = (uint32_t)hash;
+  uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+
+  for (size_t i = 0; i < m_hashes; i++) {
+    uint64_t bit = (uint64_t)(uint32_t)(h1 + i * h2) * size >> 32;
+    uint64_t mask = (uint64_t)1 << bit % 64;
+    m_setBits[generation] += (bits[bit / 64] & mask) == 0;
+    bits[bit / 64] |= mask;
+  }
+  if (generation == m_current) m_inserted++;
+}
+
+void DuplicateFilter::Rotate(double now) {
+  m_current ^= 1;
+  std::fill(m_bits.begin() + m_current * m_words, m_bits.begin() + (m_current + 1) * m_words, 0);
+  m_setBits[m_current] = 0;
+  m_inserted = 0;
+  m_started = now;
+}
+
+}  // namespace ecs
@@ -0,0 +1,80 @@
+/// \file duplicate-filter.h
+/// \brief Rotating Bloom filter for dropping flooded messages already seen.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_DUPLICATE_FILTER_H
+#define __ECS_DUPLICATE_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ecs {
+
+/// \brief Remembers message ids in a fixed memory budget, at the cost of
+///     sometimes calling a new message a duplicate. The budget is split
+///     between two Bloom filter generations: ids go into the current one and
+///     are looked up in both. The current one becomes the old one, and the
+///     old one is wiped, once it holds as many ids as keep it within the
+///     false positive target or once it has been current for the period, so
+///     an id is remembered for at least one period unless the filter fills.
+class DuplicateFilter {
+ public:
+  DuplicateFilter();
+  /// \param memory bytes for both generations, at least 16.
+  /// \param falsePositiveRate target chance of dropping a new message.
+  /// \param period seconds a generation stays current.
+  DuplicateFilter(size_t memory, double falsePositiveRate, double period);
+
+  /// \brief true if id was probably seen before, the id is recorded either way.
+  bool CheckDuplicate(uint64_t id, double now);
+
+  void Clear();
+
+  /// \brief Bytes used by the bit arrays.
+  size_t GetMemory() const { return m_bits.size() * sizeof(uint64_t); }
+  /// \brief Ids a generation takes before it is rotated out.
+  size_t GetCapacity() const { return m_capacity; }
+  size_t GetNumHashes() const { return m_hashes; }
+  /// \brief Fraction of the current generation's bits that are set.
+  double GetOccupancy() const;
+  /// \brief Chance a new id would be reported as a duplicate right now.
+  double GetFalsePositiveRate() const;
+  /// \brief Expected number of new messages dropped as duplicates so far.
+  double GetEstimatedFalseDrops() const { return m_falseDrops; }
+
+ private:
+  bool Contains(size_t generation, uint64_t hash) const;
+  void Insert(size_t generation, uint64_t hash);
+  void Rotate(double now);
+
+  // both generations back to back, each m_words long
+  std::vector<uint64_t> m_bits;
+  size_t m_words;
+  size_t m_capacity;
+  size_t m_hashes;
+  double m_period;
+
+  size_t m_current;
+  size_t m_inserted;
+  size_t m_setBits[2];
+  double m_started;
+  double m_falseDrops;
+};
+
+}  // namespace ecs
+
+#endif
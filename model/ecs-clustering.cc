@@ -13,6 +13,7 @@ Random thoughts:
 #include <map>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <cfloat>
 #include <limits>
@@ -21,16 +22,21 @@ Random thoughts:
 #include "ns3/application.h"
 #include "ns3/applications-module.h"
 #include "ns3/attribute.h"
+#include "ns3/boolean.h"
 //#include "ns3/core-module.h"
 #include "ns3/double.h"
 #include "ns3/enum.h"
+#include "ns3/ipv4-l3-protocol.h"
 #include "ns3/node-container.h"
 #include "ns3/object-base.h"
 #include "ns3/object-factory.h"
 #include "ns3/output-stream-wrapper.h"
 #include "ns3/pointer.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
 #include "ns3/udp-socket-factory.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/string.h"
 
 #include "logging.h"
 #include "nsutil.h"
@@ -44,8 +50,12 @@ namespace ecs {
 
 using namespace ns3;
 
-static Ptr<Packet> GeneratePacket(const ecs::packets::Message message);
-static ecs::packets::Message ParsePacket(const Ptr<Packet> packet);
+// clock the information table reads in Lazy expiry mode
+static double NowSeconds() { return Simulator::Now().GetSeconds(); }
+
+static Ptr<Packet> GeneratePacket(const ecs::packets::Message& message);
+static bool ParsePacket(Ptr<Packet> packet, ecs::packets::Message& message);
+static void PatchHello(std::vector<uint8_t>& bytes, bool binary, uint64_t id, uint32_t timestamp);
 
 NS_OBJECT_ENSURE_REGISTERED(ecsClusterApp);
 
@@ -56,7 +66,7 @@ TypeId ecsClusterApp::GetTypeId() {
     .AddConstructor<ecsClusterApp>()
     .AddAttribute(
       "NeighborhoodSize",
-      "Number of hops considered to be in the neightborhood of this node (h)",
+      "Number of hops considered to be in the neightborhood of this node (h), radio links with a NeighborOracle, route hop counts otherwise",
       UintegerValue(1),
       MakeUintegerAccessor(&ecsClusterApp::m_neighborhoodHops),
       MakeUintegerChecker<uint32_t>(1))
@@ -72,12 +82,187 @@ TypeId ecsClusterApp::GetTypeId() {
       TimeValue(6.0_sec),
       MakeTimeAccessor(&ecsClusterApp::m_profileDelay),
       MakeTimeChecker(0.1_sec))
+    .AddAttribute(
+      "HistoryDepth",
+      "Number of neighbourhood scans kept to compute the change degree over",
+      UintegerValue(6),
+      MakeUintegerAccessor(&ecsClusterApp::m_history_depth),
+      MakeUintegerChecker<uint16_t>(1))
     .AddAttribute(
       "WaitTime",
       "The time waited before a coming alive",
       TimeValue(30.0_sec),
       MakeTimeAccessor(&ecsClusterApp::m_waitTime),
-      MakeTimeChecker(0.1_sec));
+      MakeTimeChecker(0.1_sec))
+    .AddAttribute(
+      "NeighborRefresh",
+      "How the neighbourhood and information table are refreshed, polled every ScanInterval or when their inputs change",
+      EnumValue(static_cast<int>(RefreshMode::POLL)),
+      MakeEnumAccessor(&ecsClusterApp::m_refresh_mode),
+      MakeEnumChecker(static_cast<int>(RefreshMode::POLL), "Poll",
+                      static_cast<int>(RefreshMode::EVENT), "Event"))
+    .AddAttribute(
+      "InformationExpiry",
+      "How stale information table rows are dropped, swept on every refresh or skipped when read",
+      EnumValue(EXPIRY_SWEEP),
+      MakeEnumAccessor(&ecsClusterApp::m_expiry_mode),
+      MakeEnumChecker(EXPIRY_SWEEP, "Sweep", EXPIRY_LAZY, "Lazy"))
+    .AddAttribute(
+      "CompactionThreshold",
+      "Fraction of the information table found stale that triggers a compaction in Lazy mode",
+      DoubleValue(0.5),
+      MakeDoubleAccessor(&ecsClusterApp::m_compaction_threshold),
+      MakeDoubleChecker<double>(0.0, 1.0))
+    .AddAttribute(
+      "DuplicateFilter",
+      "How messages already received are recognised, an exact window per sender or a fixed size Bloom filter",
+      EnumValue(DEDUPE_WINDOW),
+      MakeEnumAccessor(&ecsClusterApp::m_dedupe_mode),
+      MakeEnumChecker(DEDUPE_WINDOW, "Window", DEDUPE_BLOOM, "Bloom"))
+    .AddAttribute(
+      "FilterFalsePositiveRate",
+      "Target chance of the Bloom duplicate filter dropping a new message",
+      DoubleValue(0.001),
+      MakeDoubleAccessor(&ecsClusterApp::m_filter_false_positive_rate),
+      MakeDoubleChecker<double>(0.0, 0.5))
+    .AddAttribute(
+      "FilterMemory",
+      "Bytes each node spends on the Bloom duplicate filter",
+      UintegerValue(4096),
+      MakeUintegerAccessor(&ecsClusterApp::m_filter_memory),
+      MakeUintegerChecker<uint32_t>(16))
+    .AddAttribute(
+      "CoalesceWindow",
+      "Messages to the same destination sent within this time go out as one frame, 0 sends each at once",
+      TimeValue(Seconds(0)),
+      MakeTimeAccessor(&ecsClusterApp::m_coalesce_window),
+      MakeTimeChecker(Seconds(0)))
+    .AddAttribute(
+      "PiggybackDelay",
+      "A status reply waits for the next hello when that is due within this time, 0 sends it at once",
+      TimeValue(Seconds(0)),
+      MakeTimeAccessor(&ecsClusterApp::m_piggyback_delay),
+      MakeTimeChecker(Seconds(0)))
+    .AddAttribute(
+      "WireFormat",
+      "How messages are encoded on the wire, protobuf or the fixed layout EcsHeader",
+      EnumValue(WIRE_PROTOBUF),
+      MakeEnumAccessor(&ecsClusterApp::m_wire_format),
+      MakeEnumChecker(WIRE_PROTOBUF, "Protobuf", WIRE_BINARY, "Binary"))
+    .AddAttribute(
+      "HelloScheduler",
+      "Send a hello every hello interval, or pace them with a Trickle timer",
+      EnumValue(HELLO_FIXED),
+      MakeEnumAccessor(&ecsClusterApp::m_hello_mode),
+      MakeEnumChecker(HELLO_FIXED, "Fixed", HELLO_TRICKLE, "Trickle"))
+    .AddAttribute(
+      "TrickleImin",
+      "Shortest Trickle interval, used again after every inconsistency",
+      TimeValue(1.0_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_trickle_imin),
+      MakeTimeChecker(0.1_sec))
+    .AddAttribute(
+      "TrickleImax",
+      "Longest Trickle interval a quiet neighbourhood doubles up to, past MaxValidHelloInterval neighbours drop this node between hellos",
+      TimeValue(4.0_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_trickle_imax),
+      MakeTimeChecker(0.1_sec))
+    .AddAttribute(
+      "TrickleRedundancy",
+      "Consistent hellos heard in an interval that suppress this node's own, 0 never suppresses. A hello is still sent when neighbours would drop this node before the next one",
+      UintegerValue(1),
+      MakeUintegerAccessor(&ecsClusterApp::m_trickle_redundancy),
+      MakeUintegerChecker<uint32_t>())
+    .AddAttribute(
+      "MaxValidHelloInterval",
+      "Longest advertised hello interval a neighbour's row is kept for, 2.3 of these at most",
+      TimeValue(4.0_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_max_valid_hello_interval),
+      MakeTimeChecker(0.1_sec))
+    .AddAttribute(
+      "ScanInterval",
+      "Time between refreshes of the neighbourhood and information table in Poll mode",
+      TimeValue(0.1_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_table_scan_timeout),
+      MakeTimeChecker(0.01_sec))
+    .AddAttribute(
+      "SafetyScanInterval",
+      "Longest time between refreshes in Event mode, catches routes that expire without a control message",
+      TimeValue(1.0_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_safety_scan_timeout),
+      MakeTimeChecker(0.01_sec))
+    .AddAttribute(
+      "RefreshHoldoff",
+      "Delay between the first change notification and the refresh in Event mode, later notifications are folded into it",
+      TimeValue(0.1_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_refresh_holdoff),
+      MakeTimeChecker(0.0_sec))
+    .AddAttribute(
+      "AdaptiveTimers",
+      "Stretch the scan and hello intervals while the neighbourhood change degree stays low",
+      BooleanValue(false),
+      MakeBooleanAccessor(&ecsClusterApp::m_adaptive_timers),
+      MakeBooleanChecker())
+    .AddAttribute(
+      "MinScanInterval",
+      "Shortest Poll mode scan interval when AdaptiveTimers is set",
+      TimeValue(0.1_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_min_scan_interval),
+      MakeTimeChecker(0.01_sec))
+    .AddAttribute(
+      "MaxScanInterval",
+      "Longest Poll mode scan interval when AdaptiveTimers is set",
+      TimeValue(1.6_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_max_scan_interval),
+      MakeTimeChecker(0.01_sec))
+    .AddAttribute(
+      "MinHelloInterval",
+      "Shortest hello interval when AdaptiveTimers is set",
+      TimeValue(1.0_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_min_hello_interval),
+      MakeTimeChecker(0.1_sec))
+    .AddAttribute(
+      "MaxHelloInterval",
+      "Longest hello interval when AdaptiveTimers is set",
+      TimeValue(4.0_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_max_hello_interval),
+      MakeTimeChecker(0.1_sec))
+    .AddAttribute(
+      "ChangeSmoothing",
+      "Weight of the newest change degree in its exponential moving average",
+      DoubleValue(0.3),
+      MakeDoubleAccessor(&ecsClusterApp::m_change_smoothing),
+      MakeDoubleChecker<double>(0.0, 1.0))
+    .AddAttribute(
+      "ChangeWindow",
+      "Time the change degree that drives AdaptiveTimers is measured over, within the last HistoryDepth scans",
+      TimeValue(0.5_sec),
+      MakeTimeAccessor(&ecsClusterApp::m_change_window),
+      MakeTimeChecker(0.01_sec))
+    .AddAttribute(
+      "LowChangeDegree",
+      "Smoothed change degree below which the adaptive intervals are stretched",
+      DoubleValue(0.05),
+      MakeDoubleAccessor(&ecsClusterApp::m_low_change_degree),
+      MakeDoubleChecker<double>(0.0, 1.0))
+    .AddAttribute(
+      "HighChangeDegree",
+      "Change degree above which the adaptive intervals drop back to their minimum",
+      DoubleValue(0.25),
+      MakeDoubleAccessor(&ecsClusterApp::m_high_change_degree),
+      MakeDoubleChecker<double>(0.0, 1.0))
+    .AddAttribute(
+      "NeighborOracle",
+      "Shared position based neighbour oracle, the routing table is used when not set. Only the oracle gives complete multi-hop neighbourhoods",
+      PointerValue(),
+      MakePointerAccessor(&ecsClusterApp::m_neighborOracle),
+      MakePointerChecker<NeighborOracle>())
+    .AddAttribute(
+      "RoutingAdapter",
+      "Routing protocol adapter to read neighbours with (aodv, dsdv, olsr or text), picked from the node's protocol when empty",
+      StringValue(""),
+      MakeStringAccessor(&ecsClusterApp::m_routing_adapter),
+      MakeStringChecker());
   return id;
 }
 
@@ -97,12 +282,50 @@ void ecsClusterApp::StartApplication() {
   }
 
   m_address = GetID();
-  m_peerTable = Table(m_profileDelay.GetSeconds(), m_neighborhoodHops);
+  m_peerTable = Table(m_history_depth, m_neighborhoodHops);
+  if(m_neighborOracle != 0) {
+    m_neighborSource = Create<OracleNeighborSource>(m_neighborOracle, m_address);
+  } else {
+    m_neighborSource = NeighborSource::Create(GetNode()->GetObject<Ipv4>(), m_routing_adapter);
+  }
   m_state = State::RUNNING;
   m_node_status = Node_Status::UNSPECIFIED;
   m_hello_message_timeout = 1.0_sec;
-  m_table_scan_timeout = 0.1_sec;
   m_valid_entry_timeout = 2.3_sec;
+  m_scanning = false;
+  if(m_expiry_mode == EXPIRY_LAZY) {
+    m_informationTable.SetLazyExpiry(&NowSeconds, m_compaction_threshold);
+  }
+  for(HelloTemplate& hello : m_hello_templates) {
+    hello.bytes.clear();
+  }
+  // the headers hold their heads inline, so once the frame has room for a
+  // full packet decoding one does not allocate
+  m_frame.reserve(MAX_FRAME_SIZE / EcsHeader::FIXED_SIZE);
+  if(m_dedupe_mode == DEDUPE_BLOOM) {
+    // ids are remembered for at least as long as a neighbour's row is
+    m_duplicate_filter.reset(new DuplicateFilter(m_filter_memory, m_filter_false_positive_rate,
+        m_valid_entry_timeout.GetSeconds()));
+  }
+
+  if(m_adaptive_timers) {
+    m_scan_interval = AdaptiveInterval(m_min_scan_interval, m_max_scan_interval,
+        m_change_smoothing, m_low_change_degree, m_high_change_degree);
+    m_hello_interval = AdaptiveInterval(m_min_hello_interval, m_max_hello_interval,
+        m_change_smoothing, m_low_change_degree, m_high_change_degree);
+    m_table_scan_timeout = m_scan_interval.Get();
+    m_hello_message_timeout = m_hello_interval.Get();
+  }
+  if(m_hello_mode == HELLO_TRICKLE) {
+    m_trickle = TrickleTimer(m_trickle_imin, m_trickle_imax, m_trickle_redundancy);
+    m_trickle_offset = CreateObject<UniformRandomVariable> ();
+    m_hello_message_timeout = m_trickle.GetInterval();
+  }
+
+  if(m_refresh_mode == RefreshMode::EVENT) {
+    GetNode()->GetObject<Ipv4L3Protocol>()->TraceConnectWithoutContext(
+      "LocalDeliver", MakeCallback(&ecsClusterApp::HandleLocalDeliver, this));
+  }
 
   ScheduleWakeup();
   Simulator::Schedule(57.0_sec, &ecsClusterApp::ScheduleAverageRecording, this);
@@ -131,22 +354,43 @@ void ecsClusterApp::StopApplication() {
     m_election_socket = 0;
   }
   m_state = State::STOPPED;
+  if(m_refresh_mode == RefreshMode::EVENT) {
+    GetNode()->GetObject<Ipv4L3Protocol>()->TraceDisconnectWithoutContext(
+      "LocalDeliver", MakeCallback(&ecsClusterApp::HandleLocalDeliver, this));
+  }
   //TODO: Cancel events
   
   m_ping_event.Cancel();
   m_table_update_event.Cancel();
   m_CH_claim_event.Cancel();
   m_hello_event.Cancel();
+  m_trickle_event.Cancel();
   m_table_scan_event.Cancel();
+  m_refresh_event.Cancel();
   m_check_CHResign_event.Cancel();
   m_print_table_event.Cancel();
+  m_flush_event.Cancel();
+  m_outbound.clear();
+  m_piggybacked.clear();
+
+  if(m_dedupe_mode == DEDUPE_BLOOM) {
+    stats.IncreaseFilterFalseDrops(m_duplicate_filter->GetEstimatedFalseDrops());
+    m_duplicate_filter.reset();
+  }
 }
 
 ecsClusterApp::Node_Status ecsClusterApp::GetStatus() const { return m_node_status; }
 ecsClusterApp::State ecsClusterApp::GetState() const { return m_state; }
 
 void ecsClusterApp::SetStatus(ecsClusterApp::Node_Status status) {
-  m_node_status = status;
+  if(status != Node_Status::CLUSTER_HEAD) {
+    m_members.Clear();
+  }
+  if(status != m_node_status) {
+    stats.IncreaseStatusChanges();
+    m_node_status = status;
+    ResetTrickle();
+  }
 }
 
 // this will get the nodes IPv4 address and return it as a 32 bit integer
@@ -208,91 +452,388 @@ void ecsClusterApp::SendToNodes(Ptr<Packet> message, const std::set<uint32_t> no
 Generate messages to be sent
 **/
 Ptr<Packet> ecsClusterApp::GeneratePing(uint8_t node_status) {
-  ecs::packets::Message message;
-  message.set_id(GenerateMessageID());
-  message.set_timestamp(Simulator::Now().GetMilliSeconds());
-  message.set_node_status(node_status);
+  uint64_t id = GenerateMessageID();
+  uint32_t timestamp = Simulator::Now().GetMilliSeconds();
+  if(node_status >= NUM_NODE_STATUSES) {
+    EcsHeader message = BuildPing(node_status);
+    message.SetId(id);
+    message.SetTimestamp(timestamp);
+    return EncodeMessage(message);
+  }
 
-  message.mutable_ping();
-  return GeneratePacket(message);
+  HelloTemplate& hello = m_hello_templates[node_status];
+  if(!IsHelloCurrent(hello, node_status)) {
+    EcsHeader message = BuildPing(node_status);
+    // placeholders, a zero would leave the field out of the protobuf encoding
+    message.SetId(UINT64_MAX);
+    message.SetTimestamp(UINT32_MAX);
+    Ptr<Packet> packet = EncodeMessage(message);
+    hello.bytes.resize(packet->GetSize());
+    packet->CopyData(hello.bytes.data(), hello.bytes.size());
+    hello.helloInterval = m_hello_message_timeout.GetMilliSeconds();
+    hello.heads.assign(message.GetHeads(), message.GetHeads() + message.GetNumHeads());
+  }
+
+  PatchHello(hello.bytes, m_wire_format == WIRE_BINARY, id, timestamp);
+  return Create<Packet>(hello.bytes.data(), hello.bytes.size());
 }
 
-Ptr<Packet> ecsClusterApp::GenerateStatus(uint8_t node_status) {
-  ecs::packets::Message message;
-  message.set_id(GenerateMessageID());
-  message.set_timestamp(Simulator::Now().GetMilliSeconds());
-  message.set_node_status(node_status);
+// Both encodings start with the id and then the timestamp at a fixed offset,
+// EcsHeader after its type and status bytes in network order, protobuf as the
+// fixed64 field 1 and fixed32 field 2 which it always writes first
+static const size_t BINARY_ID_OFFSET = 2;
+static const size_t BINARY_TIMESTAMP_OFFSET = 10;
+static const size_t PROTOBUF_ID_OFFSET = 1;
+static const size_t PROTOBUF_TIMESTAMP_OFFSET = 10;
+
+static void PatchHello(std::vector<uint8_t>& bytes, bool binary, uint64_t id, uint32_t timestamp) {
+  if(binary) {
+    for(size_t i = 0; i < 8; i++) bytes[BINARY_ID_OFFSET + i] = id >> (56 - 8 * i);
+    for(size_t i = 0; i < 4; i++) bytes[BINARY_TIMESTAMP_OFFSET + i] = timestamp >> (24 - 8 * i);
+  } else {
+    NS_ASSERT(bytes[PROTOBUF_ID_OFFSET - 1] == 0x09 && bytes[PROTOBUF_TIMESTAMP_OFFSET - 1] == 0x15);
+    for(size_t i = 0; i < 8; i++) bytes[PROTOBUF_ID_OFFSET + i] = id >> (8 * i);
+    for(size_t i = 0; i < 4; i++) bytes[PROTOBUF_TIMESTAMP_OFFSET + i] = timestamp >> (8 * i);
+  }
+}
 
-  message.mutable_status();
-  return GeneratePacket(message);
+// true when the cached hello still carries the current interval and heads
+bool ecsClusterApp::IsHelloCurrent(const HelloTemplate& hello, uint8_t node_status) {
+  if(hello.bytes.empty() || hello.helloInterval != m_hello_message_timeout.GetMilliSeconds()) return false;
+
+  size_t i = 0;
+  if(node_status == 2 || node_status == 3) {
+    for (auto it = m_informationTable.begin(Node_Status::CLUSTER_HEAD);
+         it != m_informationTable.end(); ++it, ++i) {
+      if(i == hello.heads.size() || hello.heads[i] != it->nodeID) return false;
+    }
+  }
+  return i == hello.heads.size();
 }
 
-Ptr<Packet> ecsClusterApp::GenerateClusterHeadClaim() {
-  ecs::packets::Message message;
-  message.set_id(GenerateMessageID());
-  message.set_timestamp(Simulator::Now().GetMilliSeconds());
+EcsHeader ecsClusterApp::BuildPing(uint8_t node_status) {
+  EcsHeader message;
+  message.SetType(EcsHeader::PING);
+  message.SetNodeStatus(node_status);
 
-  message.mutable_claim();
+  message.SetHelloInterval(m_hello_message_timeout.GetMilliSeconds());
+  // tell the heads which of them this node is a member of
+  if(node_status == 2 || node_status == 3) {
+    for (auto it = m_informationTable.begin(Node_Status::CLUSTER_HEAD); it != m_informationTable.end(); ++it) {
+      message.AddHead(it->nodeID);
+    }
+  }
+  return message;
+}
 
-  return GeneratePacket(message);
+Ptr<Packet> ecsClusterApp::GenerateStatus(uint8_t node_status, uint32_t recipient) {
+  EcsHeader message;
+  message.SetType(EcsHeader::STATUS);
+  message.SetId(GenerateMessageID());
+  message.SetTimestamp(Simulator::Now().GetMilliSeconds());
+  message.SetNodeStatus(node_status);
+  message.SetRecipient(recipient);
+
+  if(node_status == 2 || node_status == 3) {
+    for (auto it = m_informationTable.begin(Node_Status::CLUSTER_HEAD); it != m_informationTable.end(); ++it) {
+      message.AddHead(it->nodeID);
+    }
+  }
+  return EncodeMessage(message);
+}
+
+Ptr<Packet> ecsClusterApp::GenerateClusterHeadClaim() {
+  EcsHeader message;
+  message.SetType(EcsHeader::CLAIM);
+  message.SetId(GenerateMessageID());
+  message.SetTimestamp(Simulator::Now().GetMilliSeconds());
+
+  return EncodeMessage(message);
 }
 Ptr<Packet> ecsClusterApp::GenerateMeeting() {
-  ecs::packets::Message message;
-  message.set_id(GenerateMessageID());
-  message.set_timestamp(Simulator::Now().GetMilliSeconds());
+  EcsHeader message;
+  message.SetType(EcsHeader::MEETING);
+  message.SetId(GenerateMessageID());
+  message.SetTimestamp(Simulator::Now().GetMilliSeconds());
 
-  ecs::packets::Meeting * meeting = message.mutable_meeting();
-  meeting->set_tablesize(m_informationTable.size());
+  message.SetTableSize(GetClusterSize());
 
-  return GeneratePacket(message);
+  return EncodeMessage(message);
 }
 Ptr<Packet> ecsClusterApp::GenerateResign(uint8_t node_status) {
-  ecs::packets::Message message;
-  message.set_id(GenerateMessageID());
-  message.set_timestamp(Simulator::Now().GetMilliSeconds());
-  message.set_node_status(node_status);
+  EcsHeader message;
+  message.SetType(EcsHeader::RESIGN);
+  message.SetId(GenerateMessageID());
+  message.SetTimestamp(Simulator::Now().GetMilliSeconds());
+  message.SetNodeStatus(node_status);
 
-  message.mutable_resign();
+  return EncodeMessage(message);
 
-  return GeneratePacket(message);
+}
 
+// Encoding and decoding go through one buffer that only ever grows, so once
+// it has reached the largest message size no send or receive allocates for it
+static std::vector<uint8_t>& ScratchBuffer(size_t size) {
+  thread_local std::vector<uint8_t> scratch(512);
+  if(scratch.size() < size) {
+    scratch.resize(size);
+  }
+  return scratch;
 }
 
 /**
 Generate packet to be sent around
 **/
-static Ptr<Packet> GeneratePacket(const ecs::packets::Message message) {
-  uint32_t size = message.ByteSizeLong();
-  uint8_t* payload = new uint8_t[size];
+static Ptr<Packet> GeneratePacket(const ecs::packets::Message& message) {
+  size_t size = message.ByteSizeLong();
+  uint8_t* payload = ScratchBuffer(size).data();
+
+  // ByteSizeLong has cached the sizes, serialize without walking them again
+  message.SerializeWithCachedSizesToArray(payload);
+  return Create<Packet>(payload, size);
+}
+
+static bool ParsePacket(Ptr<Packet> packet, ecs::packets::Message& message) {
+  uint32_t size = packet->GetSize();
+  uint8_t* payload = ScratchBuffer(size).data();
+  packet->CopyData(payload, size);
+
+  return message.ParseFromArray(payload, size);
+}
 
-  if(!message.SerializeToArray(payload, size)) {
-    NS_LOG_ERROR("Failed to serialize the message for transmission");
+// The messages are built and handled as EcsHeaders, the protobuf format
+// translates them at the edges
+static void HeaderToMessage(const EcsHeader& header, ecs::packets::Message& message) {
+  message.set_id(header.GetId());
+  message.set_timestamp(header.GetTimestamp());
+  message.set_node_status(header.GetNodeStatus());
+
+  google::protobuf::RepeatedField<uint32_t>* heads = nullptr;
+  switch(header.GetType()) {
+    case EcsHeader::PING:
+      message.mutable_ping()->set_hello_interval(header.GetHelloInterval());
+      heads = message.mutable_ping()->mutable_heads();
+      break;
+    case EcsHeader::INQUIRY:
+      message.mutable_inquiry();
+      break;
+    case EcsHeader::CLAIM:
+      message.mutable_claim();
+      break;
+    case EcsHeader::MEETING:
+      message.mutable_meeting()->set_tablesize(header.GetTableSize());
+      break;
+    case EcsHeader::RESIGN:
+      message.mutable_resign();
+      break;
+    case EcsHeader::STATUS:
+      message.mutable_status()->set_recipient(header.GetRecipient());
+      heads = message.mutable_status()->mutable_heads();
+      break;
+    default:
+      break;
+  }
+  if(heads != nullptr) {
+    heads->Add(header.GetHeads(), header.GetHeads() + header.GetNumHeads());
+  }
+}
+
+static bool MessageToHeader(const ecs::packets::Message& message, EcsHeader& header) {
+  header = EcsHeader();
+  header.SetId(message.id());
+  header.SetTimestamp(message.timestamp());
+  header.SetNodeStatus(message.node_status());
+
+  const google::protobuf::RepeatedField<uint32_t>* heads = nullptr;
+  switch(message.payload_case()) {
+    case ecs::packets::Message::kPing:
+      header.SetType(EcsHeader::PING);
+      header.SetHelloInterval(message.ping().hello_interval());
+      heads = &message.ping().heads();
+      break;
+    case ecs::packets::Message::kInquiry:
+      header.SetType(EcsHeader::INQUIRY);
+      break;
+    case ecs::packets::Message::kClaim:
+      header.SetType(EcsHeader::CLAIM);
+      break;
+    case ecs::packets::Message::kMeeting:
+      header.SetType(EcsHeader::MEETING);
+      header.SetTableSize(message.meeting().tablesize());
+      break;
+    case ecs::packets::Message::kResign:
+      header.SetType(EcsHeader::RESIGN);
+      break;
+    case ecs::packets::Message::kStatus:
+      header.SetType(EcsHeader::STATUS);
+      header.SetRecipient(message.status().recipient());
+      heads = &message.status().heads();
+      break;
+    default:
+      return false;
+  }
+  for(int i = 0; heads != nullptr && i < heads->size(); i++) {
+    header.AddHead(heads->Get(i));
+  }
+  return true;
+}
+
+google::protobuf::ArenaOptions ecsClusterApp::ArenaBlockOptions(char* block, size_t size) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = size;
+  return options;
+}
+
+// The space counts include the initial block, anything past it came from the heap
+void ecsClusterApp::ResetArena() {
+  uint64_t used = m_arena.SpaceUsed();
+  uint64_t allocated = m_arena.Reset();
+  stats.RecordArenaReset(used, allocated - sizeof(m_arena_block));
+}
+
+// Messages built once the arena has outgrown m_arena_block live in blocks it
+// took from the heap
+void ecsClusterApp::CountArenaMessages(uint64_t messages) {
+  stats.RecordArenaMessages(messages, m_arena.SpaceAllocated() > sizeof(m_arena_block));
+}
+
+ecs::packets::Message* ecsClusterApp::NewMessage() {
+  return google::protobuf::Arena::CreateMessage<ecs::packets::Message>(&m_arena);
+}
+
+Ptr<Packet> ecsClusterApp::EncodeMessage(const EcsHeader& header) {
+  if(m_wire_format == WIRE_BINARY) {
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    return packet;
+  }
+
+  ecs::packets::Message& message = *NewMessage();
+  HeaderToMessage(header, message);
+  CountArenaMessages(1);
+  Ptr<Packet> packet = GeneratePacket(message);
+  // while a batch is being handled the received messages are still in the arena
+  if(!m_draining) {
+    ResetArena();
   }
-  Ptr<Packet> packet = Create<Packet>(payload, size);
-  delete[] payload;
   return packet;
 }
 
+// A frame appended to another keeps its own bundle, so a hello carrying
+// replies that is coalesced again nests them a level deeper. Every message
+// is read, in the order it was appended.
+static bool FlattenBundle(const ecs::packets::Message& message, std::vector<EcsHeader>& frame) {
+  for(int i = 0; i < message.bundle_size(); i++) {
+    frame.emplace_back();
+    if(!MessageToHeader(message.bundle(i), frame.back())) return false;
+    if(!FlattenBundle(message.bundle(i), frame)) return false;
+  }
+  return true;
+}
 
-static ecs::packets::Message ParsePacket(const Ptr<Packet> packet) {
-  uint32_t size = packet->GetSize();
-  uint8_t* payload = new uint8_t[size];
-  packet->CopyData(payload, size);
+bool ecsClusterApp::DecodeFrame(Ptr<Packet> packet, std::vector<EcsHeader>& frame) {
+  frame.clear();
+  if(m_wire_format == WIRE_BINARY) {
+    while(packet->GetSize() > 0) {
+      frame.emplace_back();
+      packet->RemoveHeader(frame.back());
+      if(frame.back().GetType() == EcsHeader::INVALID) return false;
+    }
+    return !frame.empty();
+  }
 
-  ecs::packets::Message message;
-  message.ParseFromArray(payload, size);
-  delete[] payload;
+  ecs::packets::Message& message = *NewMessage();
+  if(!ParsePacket(packet, message)) return false;
+  frame.emplace_back();
+  if(!MessageToHeader(message, frame.back())) return false;
+  if(!FlattenBundle(message, frame)) return false;
+  // the bundled messages were parsed onto the arena with the first one
+  CountArenaMessages(frame.size());
+  return true;
+}
 
-  return message;
+// Binary headers delimit themselves. A protobuf message appended as field 4,
+// the bundle, of the first one is parsed as part of it.
+void ecsClusterApp::AppendToFrame(Ptr<Packet> frame, Ptr<Packet> message) {
+  if(m_wire_format == WIRE_PROTOBUF) {
+    uint8_t prefix[1 + 5];
+    size_t length = 0;
+    prefix[length++] = (4 << 3) | 2;
+    for(uint32_t size = message->GetSize(); ; size >>= 7) {
+      prefix[length++] = (size & 0x7f) | (size >= 0x80 ? 0x80 : 0);
+      if(size < 0x80) break;
+    }
+    frame->AddAtEnd(Create<Packet>(prefix, length));
+  }
+  frame->AddAtEnd(message);
+  stats.IncreaseCoalescedMessages();
+}
+
+void ecsClusterApp::Transmit(uint32_t destination, Ptr<Packet> packet) {
+  if(destination == BROADCAST) {
+    BroadcastToNeighbors(packet);
+  } else {
+    SendMessage(Ipv4Address(destination), packet);
+  }
+}
+
+// Messages for the same destination within the window go out as one frame
+void ecsClusterApp::QueueMessage(uint32_t destination, Ptr<Packet> packet) {
+  if(m_coalesce_window.IsZero()) {
+    Transmit(destination, packet);
+    return;
+  }
+
+  for(auto& frame : m_outbound) {
+    if(frame.first != destination) continue;
+    if(frame.second->GetSize() + packet->GetSize() + 6 > MAX_FRAME_SIZE) {
+      Transmit(destination, frame.second);
+      frame.second = packet;
+    } else {
+      AppendToFrame(frame.second, packet);
+    }
+    return;
+  }
+
+  m_outbound.push_back(std::make_pair(destination, packet));
+  if(!m_flush_event.IsRunning()) {
+    m_flush_event = Simulator::Schedule(m_coalesce_window, &ecsClusterApp::FlushOutbound, this);
+  }
+}
+
+void ecsClusterApp::FlushOutbound() {
+  for(auto& frame : m_outbound) {
+    Transmit(frame.first, frame.second);
+  }
+  m_outbound.clear();
+}
+
+// Replies that can no longer ride on a hello go to their nodes on their own
+void ecsClusterApp::FlushPiggybacked() {
+  for(auto& status : m_piggybacked) {
+    QueueMessage(status.first, status.second);
+  }
+  m_piggybacked.clear();
+}
+
+// The hello the replies were waiting for may have moved, they stop waiting
+// once it is no longer due within the piggyback delay
+void ecsClusterApp::CheckPiggybackDeadline() {
+  if(m_piggybacked.empty()) return;
+  if(m_hello_event.IsRunning() && Simulator::GetDelayLeft(m_hello_event) <= m_piggyback_delay) return;
+  FlushPiggybacked();
 }
 
 /**
 Marshall calls this the "Actually send messages" section   :)
 **/
 void ecsClusterApp::BroadcastToNeighbors(Ptr<Packet> packet) {
+  stats.IncreaseControlBytes(packet->GetSize());
   m_neighborhood_socket->Send(packet);
 }
 void ecsClusterApp::SendMessage(Ipv4Address dest, Ptr<Packet> packet) {
+  stats.IncreaseControlBytes(packet->GetSize());
   m_socket_recv->SendTo(packet, 0, InetSocketAddress(dest, APPLICATION_PORT));
 }
 
@@ -302,33 +843,46 @@ I imagine this is just functions that call the helper functions in the other sen
 **/
 void ecsClusterApp::SendPing(uint8_t node_status) {
   Ptr<Packet> message = GeneratePing(node_status);
-  BroadcastToNeighbors(message);
+  for(auto& status : m_piggybacked) {
+    AppendToFrame(message, status.second);
+  }
+  m_piggybacked.clear();
+  QueueMessage(BROADCAST, message);
+  m_hello_covered_until = Simulator::Now() +
+      HelloValidity(m_hello_message_timeout, m_valid_entry_timeout, m_max_valid_hello_interval);
   stats.incPing();
 }
 
 void ecsClusterApp::SendClusterHeadClaim() {
   SetStatus(Node_Status::CLUSTER_HEAD);
   Ptr<Packet> message = GenerateClusterHeadClaim();
-  BroadcastToNeighbors(message);
+  QueueMessage(BROADCAST, message);
   m_CH_Claim_flag = true;
   stats.recordCHClaim(m_address, Simulator::Now().GetSeconds());
   stats.incClaim();
 }
 
 void ecsClusterApp::SendStatus(uint32_t nodeID) {
-  Ptr<Packet> message = GenerateStatus(GenerateNodeStatusToUint());
-  SendMessage(Ipv4Address(nodeID), message);
+  Ptr<Packet> message = GenerateStatus(GenerateNodeStatusToUint(), nodeID);
+  // the next hello reaches the node anyway, the reply rides along when it is
+  // due soon enough
+  if(!m_piggyback_delay.IsZero() && m_hello_event.IsRunning() &&
+     Simulator::GetDelayLeft(m_hello_event) <= m_piggyback_delay) {
+    m_piggybacked.push_back(std::make_pair(nodeID, message));
+  } else {
+    QueueMessage(nodeID, message);
+  }
   stats.incStatus();
 }
 void ecsClusterApp::SendCHMeeting(uint32_t nodeID) {
   Ptr<Packet> message = GenerateMeeting();
-  SendMessage(Ipv4Address(nodeID), message);
+  QueueMessage(nodeID, message);
   NS_LOG_UNCOND("CH Meeting Sent!");
   stats.incMeeting();
 }
 void ecsClusterApp::SendResign(uint8_t node_status) {
   Ptr<Packet> message = GenerateResign(node_status);
-  BroadcastToNeighbors(message);
+  QueueMessage(BROADCAST, message);
   if (m_CH_Claim_flag) {
     stats.recordCHResign(m_address, Simulator::Now().GetSeconds());
     m_CH_Claim_flag = false;
@@ -356,7 +910,11 @@ void ecsClusterApp::ScheduleWakeup() {
   m_CH_claim_event = Simulator::Schedule(random_m_standoff_time, &ecsClusterApp::SendClusterHeadClaim, this);
 
   //Schedule periodic events
-  m_hello_event = Simulator::Schedule(random_m_standoff_time+m_hello_message_timeout, &ecsClusterApp::ScheduleHello, this);
+  if(m_hello_mode == HELLO_TRICKLE) {
+    m_trickle_event = Simulator::Schedule(random_m_standoff_time, &ecsClusterApp::StartTrickleInterval, this);
+  } else {
+    m_hello_event = Simulator::Schedule(random_m_standoff_time+m_hello_message_timeout, &ecsClusterApp::ScheduleHello, this);
+  }
   m_table_scan_event = Simulator::Schedule(random_m_standoff_time+m_hello_message_timeout+m_table_scan_timeout, &ecsClusterApp::ScheduleScan, this);
 }
 
@@ -365,10 +923,61 @@ void ecsClusterApp::ScheduleHello() {
   m_hello_event = Simulator::Schedule(m_hello_message_timeout, &ecsClusterApp::ScheduleHello, this);
 }
 
+// Trickle mode only, each interval sends at most one hello at a random point
+// in its second half and the next interval starts when this one ends
+void ecsClusterApp::StartTrickleInterval() {
+  if(m_state != State::RUNNING) return;
+  Time t = m_trickle.StartInterval(m_trickle_offset->GetValue());
+  // the next hello can be as late as the end of the following interval, so
+  // that is advertised for neighbours to keep this node's row by
+  m_hello_message_timeout = m_trickle.GetNextInterval();
+  m_trickle_interval_end = Simulator::Now() + m_trickle.GetInterval();
+  m_hello_event = Simulator::Schedule(t, &ecsClusterApp::TrickleHello, this);
+  m_trickle_event = Simulator::Schedule(m_trickle.GetInterval(), &ecsClusterApp::EndTrickleInterval, this);
+}
+
+void ecsClusterApp::EndTrickleInterval() {
+  m_trickle.EndInterval();
+  StartTrickleInterval();
+}
+
+void ecsClusterApp::TrickleHello() {
+  // the next chance to send is in the next interval, which may end too late
+  if(!m_trickle.ShouldSend() && m_trickle_interval_end + m_trickle.GetNextInterval() <= m_hello_covered_until) {
+    stats.IncreaseSuppressedHellos();
+    FlushPiggybacked();
+    return;
+  }
+  SendPing(GenerateNodeStatusToUint());
+}
+
+// Trickle mode only, restart at Imin unless already there or not yet started
+void ecsClusterApp::ResetTrickle() {
+  if(m_hello_mode != HELLO_TRICKLE || !m_trickle_event.IsRunning()) return;
+  if(!m_trickle.Reset()) return;
+  stats.IncreaseTrickleResets();
+  m_hello_event.Cancel();
+  m_trickle_event.Cancel();
+  StartTrickleInterval();
+  CheckPiggybackDeadline();
+}
+
 void ecsClusterApp::ScheduleScan() {
-  RefreshRoutingTable();
-  RefreshInformationTable();
-  m_table_scan_event = Simulator::Schedule(m_table_scan_timeout, &ecsClusterApp::ScheduleScan, this);
+  m_scanning = true;
+  RefreshNeighborhood();
+  AdaptTimers();
+  Time next = m_refresh_mode == RefreshMode::EVENT ? m_safety_scan_timeout : m_table_scan_timeout;
+  m_table_scan_event = Simulator::Schedule(next, &ecsClusterApp::ScheduleScan, this);
+}
+
+// Event mode only, run a refresh after delay unless one is already due sooner
+void ecsClusterApp::ScheduleRefresh(Time delay) {
+  if(m_state != State::RUNNING || m_refresh_mode != RefreshMode::EVENT || !m_scanning) return;
+  if(m_refresh_event.IsRunning()) {
+    if(Simulator::GetDelayLeft(m_refresh_event) <= delay) return;
+    m_refresh_event.Cancel();
+  }
+  m_refresh_event = Simulator::Schedule(delay, &ecsClusterApp::RefreshNeighborhood, this);
 }
 
 void ecsClusterApp::ScheduleAverageRecording() {
@@ -377,7 +986,7 @@ void ecsClusterApp::ScheduleAverageRecording() {
     if(GetStatus() == Node_Status::CLUSTER_HEAD) {
       //std::cout << "increasing head!";
       stats.IncreaseCHCount();
-      stats.IncreaseClusterSizeCount(m_informationTable.size());
+      stats.IncreaseClusterSizeCount(GetClusterSize());
     } else if(GetStatus() == Node_Status::CLUSTER_MEMBER) {
       //std::cout << "increasing mem!";
       stats.IncreaseCMemCount();
@@ -391,6 +1000,9 @@ void ecsClusterApp::ScheduleAverageRecording() {
       uint64_t num_access_points = GetNumAccessPoints();
       stats.IncreaseAccessPointCount(num_access_points);
     }
+    if(m_dedupe_mode == DEDUPE_BLOOM) {
+      stats.IncreaseFilterOccupancy(m_duplicate_filter->GetOccupancy());
+    }
   }
   Simulator::Schedule(60.0_sec, &ecsClusterApp::ScheduleAverageRecording, this);
 }
@@ -422,58 +1034,99 @@ void ecsClusterApp::HandleRequest(Ptr<Socket> socket) {
   Address from;
   Address localAddress;
 
+  // every protobuf message of the batch, and any reply generated while
+  // handling it, comes from the arena and is freed at once when the socket
+  // is drained
+  m_draining = true;
   while ((packet = socket->RecvFrom(from))) {
     socket->GetSockName(localAddress);
 
     uint32_t srcAddress = InetSocketAddress::ConvertFrom(from).GetIpv4().Get();
-    ecs::packets::Message message = ParsePacket(packet);
-
-    if(CheckDuplicateMessage(message.id())) {
-      NS_LOG_INFO("already recieved this message, dropping.");
-      return;
+    if(!DecodeFrame(packet, m_frame)) {
+      NS_LOG_WARN("Failed to parse a received message, dropping.");
+      continue;
     }
-    if(message.has_ping()) {
-      //ping received
-      stats.IncreaseClusteringMessages();
-      //std::cout << "ping recieved at time " << Simulator::Now().GetSeconds() << "\n";
-      HandlePing(srcAddress, message.node_status());
-    } else if(message.has_claim()) {
-      //CH claim received
-      stats.IncreaseClusterChangeMessages();
-      stats.IncreaseClusteringMessages();
-     // std::cout << "claim recieved at time " << Simulator::Now().GetSeconds() << "\n";
-      HandleClaim(srcAddress);
-    } else if(message.has_meeting()) {
-      //clusterhead meeting, handle by sending number of connected nodes
-      //(i.e. information table size) to other. if less table size, resign
-      stats.IncreaseClusterChangeMessages();
-      stats.IncreaseClusteringMessages();
-     // std::cout << "meeting recieved at time " << Simulator::Now().GetSeconds() << "\n";
-      HandleMeeting(srcAddress,message.node_status(),message.meeting().tablesize());
-    } else if(message.has_resign()) {
-      //clusterhead meeting has occured, and the node broadcasting this message
-      //has a smaller information table, thus causing it to resign.
-      stats.IncreaseClusterChangeMessages();
-      stats.IncreaseClusteringMessages();
-      //std::cout << "resign recieved at time " << Simulator::Now().GetSeconds() << "\n";
-      HandleCHResign(srcAddress,message.node_status());
-    } else if(message.has_status()) {
-      //Simple message relaying a given node's node_status to another node.
-      //Sent when a clusterhead claim is received during cluster formation
-      //std::cout << "status recieved at time " << Simulator::Now().GetSeconds() << "\n";
-      HandleStatus(srcAddress,message.node_status());
-    } else {
-      std::cout << "handling message: other\n";
-      NS_LOG_WARN("Unknown message type");
+
+    // a frame can carry several messages, each is handled on its own
+    for(const EcsHeader& message : m_frame) {
+      if(CheckDuplicateMessage(message.GetId())) {
+        NS_LOG_INFO("already recieved this message, dropping.");
+        continue;
+      }
+      ScheduleRefresh(m_refresh_holdoff);
+      if(message.GetType() == EcsHeader::STATUS && message.GetRecipient() != 0 &&
+         message.GetRecipient() != m_address) {
+        // a reply to another node that rode along on a hello
+        continue;
+      }
+      if(message.GetType() == EcsHeader::PING) {
+        //ping received
+        stats.IncreaseClusteringMessages();
+        //std::cout << "ping recieved at time " << Simulator::Now().GetSeconds() << "\n";
+        HandlePing(srcAddress, message.GetNodeStatus(), MilliSeconds(message.GetHelloInterval()),
+                   message.GetHeads(), message.GetNumHeads());
+      } else if(message.GetType() == EcsHeader::CLAIM) {
+        //CH claim received
+        stats.IncreaseClusterChangeMessages();
+        stats.IncreaseClusteringMessages();
+       // std::cout << "claim recieved at time " << Simulator::Now().GetSeconds() << "\n";
+        HandleClaim(srcAddress);
+      } else if(message.GetType() == EcsHeader::MEETING) {
+        //clusterhead meeting, handle by sending number of connected nodes
+        //(i.e. information table size) to other. if less table size, resign
+        stats.IncreaseClusterChangeMessages();
+        stats.IncreaseClusteringMessages();
+       // std::cout << "meeting recieved at time " << Simulator::Now().GetSeconds() << "\n";
+        HandleMeeting(srcAddress,message.GetNodeStatus(),message.GetTableSize());
+      } else if(message.GetType() == EcsHeader::RESIGN) {
+        //clusterhead meeting has occured, and the node broadcasting this message
+        //has a smaller information table, thus causing it to resign.
+        stats.IncreaseClusterChangeMessages();
+        stats.IncreaseClusteringMessages();
+        //std::cout << "resign recieved at time " << Simulator::Now().GetSeconds() << "\n";
+        HandleCHResign(srcAddress,message.GetNodeStatus());
+      } else if(message.GetType() == EcsHeader::STATUS) {
+        //Simple message relaying a given node's node_status to another node.
+        //Sent when a clusterhead claim is received during cluster formation
+        //std::cout << "status recieved at time " << Simulator::Now().GetSeconds() << "\n";
+        HandleStatus(srcAddress,message.GetNodeStatus(),message.GetHeads(),message.GetNumHeads());
+      } else {
+        std::cout << "handling message: other\n";
+        NS_LOG_WARN("Unknown message type");
+      }
     }
   }
+  m_draining = false;
+  ResetArena();
 }
+
+// Routing control messages are how AODV and DSDV learn about new or broken
+// routes, so one that adds or breaks a route within reach is the cue to look at
+// the routing table again. Hellos and periodic updates that only refresh known
+// routes are not.
+void ecsClusterApp::HandleLocalDeliver(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface) {
+  if(header.GetProtocol() != UdpL4Protocol::PROT_NUMBER) return;
+  uint16_t port = m_neighborSource ? m_neighborSource->GetControlPort() : 0;
+  if(port == 0) return;
+
+  UdpHeader udp;
+  packet->PeekHeader(udp);
+  if(udp.GetDestinationPort() != port) return;
+
+  Ptr<Packet> message = packet->Copy();
+  message->RemoveHeader(udp);
+  if(m_neighborSource->ChangesNeighbors(header.GetSource(), message, m_neighborhoodHops,
+                                        m_peerTable.GetNeighbors())) {
+    ScheduleRefresh(m_refresh_holdoff);
+  }
+}
+
 /**
 Message handlers below. Above is sorting the messages from one another
 **/
 
 //Handles pings being received from another node (probably will be used to update information table)
-void ecsClusterApp::HandlePing(uint32_t nodeID, uint8_t node_status) {
+void ecsClusterApp::HandlePing(uint32_t nodeID, uint8_t node_status, Time helloInterval, const uint32_t* heads, size_t numHeads) {
   // set up row to check
   InformationTableRow row;
   row.nodeID = nodeID;
@@ -481,28 +1134,13 @@ void ecsClusterApp::HandlePing(uint32_t nodeID, uint8_t node_status) {
   row.clusterHeadID = 0;
   row.accessPointID = 0;
   row.entryTime = Simulator::Now().GetSeconds();
+  // a sender that has stretched its hello interval is kept for as many of its
+  // intervals as the default timeout allows for the default interval, up to
+  // MaxValidHelloInterval of them
+  row.validTime = HelloValidity(helloInterval, m_valid_entry_timeout, m_max_valid_hello_interval).GetSeconds();
 
-  //check if node already exists in table
-  std::list<InformationTableRow>::iterator it;
-  //bool nodeExists = false;
-  //uint32_t count = 0;
-  //std::cout << "table size: " << m_informationTable.size() << "\n";
-  for (it = m_informationTable.begin(); it != m_informationTable.end(); it++) {
-    //std::cout << "count " << count << "\n";
-    //count++;
-    // if(++count >= m_informationTable.size())
-    //     break;
-//    std::cout << "it: " << it->nodeID << " row: " << row.nodeID << "\n";
-    if(it->nodeID==row.nodeID) {
-      //std::cout << "erasing node " << it->nodeID << "\n";
-      m_informationTable.erase(it++);
-      //break;
-      //m_informationTable.push_back(row);
-      //nodeExists = true;
-    }
-    
-  }
-  m_informationTable.push_back(row);
+  UpsertNeighbor(row, true);
+  UpdateMembership(nodeID, row.status, heads, numHeads, row.validTime);
   
   switch (node_status) {
   case 1: //CH sent ping
@@ -607,7 +1245,8 @@ void ecsClusterApp::HandleClaim(uint32_t nodeID) {
   row.clusterHeadID = 0;
   row.accessPointID = 0;
   row.entryTime = Simulator::Now().GetSeconds();
-  m_informationTable.push_back(row);
+  row.validTime = m_valid_entry_timeout.GetSeconds();
+  UpsertNeighbor(row, false);
   //m_informationTable[nodeID] = std::pair<Node_Status::CLUSTER_HEAD, Simulator::Now().GetSeconds()>;
   //if in standoff, automatically join their cluster
   //NS_LOG_UNCOND("standoffTime for " << GetID() << " is " << m_standoff_time << " NStime= " << Simulator::Now());
@@ -665,7 +1304,8 @@ void ecsClusterApp::HandleResponse(uint32_t nodeID, uint8_t node_status) {
   row.clusterHeadID = 0;
   row.accessPointID = 0;
   row.entryTime = Simulator::Now().GetSeconds();
-  m_informationTable.push_back(row);
+  row.validTime = m_valid_entry_timeout.GetSeconds();
+  UpsertNeighbor(row, false);
   //m_informationTable[nodeID] = std::pair<GenerateStatusFromUint(node_status), Simulator::Now().GetSeconds()>;
 }
 //Handles ClusterHeadMeeting messaage received
@@ -677,14 +1317,14 @@ void ecsClusterApp::HandleMeeting(uint32_t nodeID, uint8_t node_status, uint64_t
   //sending node's degree is greater than this node's, therefore resign
   //EQUAL TO WAS NOT ACTUALLY DISCUSSED IN ORIGINAL PAPER
   //For simplicity's sake, still resign due to minimizing number of messages.
-  if(neighborhood_size >= m_informationTable.size()) {
+  if(neighborhood_size >= GetClusterSize()) {
     //Send CHResign
     SendResign(GenerateNodeStatusToUint());
     SetStatus(Node_Status::CLUSTER_MEMBER);
     //Broadcast new status to update nodes
     SendPing(nodeID);
     stats.recordMembershipStart(NodeStatusToStringFromTable(m_node_status), m_address, Simulator::Now().GetSeconds(), nodeID);
-  } else if(neighborhood_size < m_informationTable.size()) {
+  } else if(neighborhood_size < GetClusterSize()) {
     //Send CHmeeting back to original with my size
     SendCHMeeting(nodeID);
   } else {
@@ -699,29 +1339,20 @@ void ecsClusterApp::HandleCHResign(uint32_t nodeID, uint8_t node_status) {
   row.clusterHeadID = 0;
   row.accessPointID = 0;
   row.entryTime = Simulator::Now().GetSeconds();
-  m_informationTable.push_back(row);
+  row.validTime = m_valid_entry_timeout.GetSeconds();
+  UpsertNeighbor(row, false);
   //m_informationTable[nodeID] = std::pair<GenerateStatusFromUint(node_status), Simulator::Now().GetSeconds()>;
 
   //if gateway, check for number of CHs
   if(m_node_status == Node_Status::CLUSTER_GATEWAY) {
-    std::list<InformationTableRow>::iterator it;
-    std::list<uint32_t> ch_IDs;
-    int num_CHs = 0;
-    int num_mems = 0;
-    for (it = m_informationTable.begin(); it != m_informationTable.end(); it++) {
-      if(it->status == Node_Status::CLUSTER_HEAD) {
-        num_CHs+=1;
-        ch_IDs.push_back(it->nodeID);
-      } else if(it->status == Node_Status::CLUSTER_MEMBER || it->status == Node_Status::CLUSTER_GATEWAY) {
-        num_mems+=1;
-      }
-    }
+    size_t num_CHs = GetNumHeadsCovering();
+    size_t num_mems = GetNumAccessPoints();
     // If 1 CH, change to CM
     if(num_CHs == 1) {
       SetStatus(Node_Status::CLUSTER_MEMBER);
       SendPing(GenerateNodeStatusToUint());
       stats.recordMembershipEnd(NodeStatusToStringFromTable(m_node_status), m_address, Simulator::Now().GetSeconds(), nodeID);
-      stats.recordMembershipStart(NodeStatusToStringFromTable(m_node_status), m_address, Simulator::Now().GetSeconds(), ch_IDs.front());
+      stats.recordMembershipStart(NodeStatusToStringFromTable(m_node_status), m_address, Simulator::Now().GetSeconds(), m_informationTable.begin(Node_Status::CLUSTER_HEAD)->nodeID);
     } else if(num_CHs == 0 && num_mems>0) {
       //std::cout << "setting cguest from resign\n";
       SetStatus(Node_Status::CLUSTER_GUEST);
@@ -731,9 +1362,8 @@ void ecsClusterApp::HandleCHResign(uint32_t nodeID, uint8_t node_status) {
       SetStatus(Node_Status::CLUSTER_GATEWAY);
       SendPing(GenerateNodeStatusToUint());
       stats.recordMembershipEnd(NodeStatusToStringFromTable(m_node_status), m_address, Simulator::Now().GetSeconds(), nodeID);
-      std::list<uint32_t>:: iterator chIterator;
-      for(chIterator = ch_IDs.begin(); chIterator != ch_IDs.end(); chIterator++) {
-        stats.recordMembershipStart(NodeStatusToStringFromTable(m_node_status), m_address, Simulator::Now().GetSeconds(), *chIterator);
+      for (auto it = m_informationTable.begin(Node_Status::CLUSTER_HEAD); it != m_informationTable.end(); ++it) {
+        stats.recordMembershipStart(NodeStatusToStringFromTable(m_node_status), m_address, Simulator::Now().GetSeconds(), it->nodeID);
       }
       
     }
@@ -745,15 +1375,7 @@ void ecsClusterApp::HandleCHResign(uint32_t nodeID, uint8_t node_status) {
   if(m_node_status != Node_Status::CLUSTER_HEAD) {
     //iterate through information table, if any heads, break, otherwise send CH claim
     //NS_LOG_UNCOND("RESIGN HANDLE - CHECKING FOR CH IN INFORMATION TABLE");
-    std::list<InformationTableRow>::iterator it;
-    bool checkForCH = true;
-    for (it = m_informationTable.begin(); it != m_informationTable.end(); it++) {
-      if(it->status == Node_Status::CLUSTER_HEAD) {
-        checkForCH=false;
-        break;
-      }
-    }
-    if(checkForCH) {
+    if(GetNumHeadsCovering() == 0) {
       //Should be cancellable now that it is an event
       Ptr<UniformRandomVariable> standoff = CreateObject<UniformRandomVariable> ();
       standoff->SetAttribute("Min", DoubleValue(0.1));
@@ -766,14 +1388,16 @@ void ecsClusterApp::HandleCHResign(uint32_t nodeID, uint8_t node_status) {
 }
 
 //Handles status message from neighbor in response to clusterhead claim during standoff
-void ecsClusterApp::HandleStatus(uint32_t nodeID, uint8_t node_status) {
+void ecsClusterApp::HandleStatus(uint32_t nodeID, uint8_t node_status, const uint32_t* heads, size_t numHeads) {
   InformationTableRow row;
   row.nodeID = nodeID;
   row.status = GenerateStatusFromUint(node_status);
   row.clusterHeadID = 0;
   row.accessPointID = 0;
   row.entryTime = Simulator::Now().GetSeconds();
-  m_informationTable.push_back(row);
+  row.validTime = m_valid_entry_timeout.GetSeconds();
+  UpsertNeighbor(row, false);
+  UpdateMembership(nodeID, row.status, heads, numHeads, row.validTime);
   //m_informationTable[nodeID] = std::pair<GenerateStatusFromUint(node_status), Simulator::Now().GetSeconds()>;
   if (m_CH_Claim_flag) {
     //NS_LOG_UNCOND("recording status recieve");
@@ -784,11 +1408,14 @@ void ecsClusterApp::HandleStatus(uint32_t nodeID, uint8_t node_status) {
 }
 
 bool ecsClusterApp::CheckDuplicateMessage(uint64_t messageID) {
-  // true if it is in the list
-  bool status = m_received_messages.find(messageID) != m_received_messages.end();
-  m_received_messages.insert(messageID);
-
-  return status;
+  // the Bloom filter answers true if the id was probably seen before, which
+  // includes the occasional new id that collides with remembered ones
+  if(m_dedupe_mode == DEDUPE_BLOOM) {
+    return m_duplicate_filter->CheckDuplicate(messageID, Simulator::Now().GetSeconds());
+  }
+  // the replay window answers true if the id was seen before or its sequence
+  // is older than the sender's window
+  return m_received_messages.CheckDuplicate(messageID, Simulator::Now().GetSeconds());
 }
 
 //Simple function which translates the Node_Status enum to an integer for easier communication
@@ -873,44 +1500,62 @@ ecsClusterApp::Node_Status ecsClusterApp::GenerateStatusFromUint(uint8_t status)
 }
 
 
-// this will generate the ID value to use for the requests this is a static function that should be
-// called to generate all the ids to ensure they are unique
+// this will generate the ID value to use for the requests, the sender's address
+// and its own sequence number, which are unique without a global counter
 uint64_t ecsClusterApp::GenerateMessageID() {
-  static uint64_t id = 0;
-  return ++id;
+  return MakeMessageId(m_address, ++m_message_sequence);
 }
 
-std::string ecsClusterApp::GetRoutingTableString() {
-  Ptr<Ipv4> ipv4 = GetNode()->GetObject<Ipv4>();
-  Ptr<Ipv4RoutingProtocol> table = ipv4->GetRoutingProtocol();
-  NS_ASSERT(table);
-  std::ostringstream ss;
-  table->PrintRoutingTable(Create<OutputStreamWrapper>(&ss));
+void ecsClusterApp::RefreshRoutingTable() {
+  //NS_LOG_UNCOND("HERE1");
+  NS_ASSERT(m_neighborSource);
+  m_peerTable.UpdateTable(*m_neighborSource, Simulator::Now().GetSeconds());
+}
 
-  return ss.str();
+void ecsClusterApp::RefreshNeighborhood() {
+  RefreshRoutingTable();
+  // lazy rows are dropped as they are read, nothing has to wake up for them
+  if(m_expiry_mode == EXPIRY_SWEEP) {
+    RefreshInformationTable();
+  }
+  m_members.Expire(Simulator::Now().GetSeconds());
+  // nothing from a sender gone this long is still in flight
+  m_received_messages.Expire(Simulator::Now().GetSeconds() - m_valid_entry_timeout.GetSeconds());
+  stats.incScan();
+
+  if(m_refresh_mode != RefreshMode::EVENT || m_expiry_mode == EXPIRY_LAZY || m_informationTable.empty()) return;
+
+  // wake up again just after the oldest entry becomes stale
+  double expires = m_informationTable.NextExpiry();
+  Time expiry = Seconds(expires) - Simulator::Now();
+  ScheduleRefresh(std::max(expiry, Time(0)) + m_refresh_holdoff);
 }
 
-void ecsClusterApp::RefreshRoutingTable() {
-  //NS_LOG_UNCOND("HERE1");
-  m_peerTable.UpdateTable(GetRoutingTableString());
+// Stretch or tighten the scan and hello intervals to follow the change degree
+// of the neighbourhood, a change of hello interval is applied from the next hello
+void ecsClusterApp::AdaptTimers() {
+  if(!m_adaptive_timers) return;
+
+  // measured over a fixed time so stretching the scans does not inflate it
+  double changeDegree = m_peerTable.ComputeChangeDegreeOver(m_change_window.GetSeconds());
+  m_table_scan_timeout = m_scan_interval.Update(changeDegree);
+  // Trickle paces the hellos itself
+  if(m_hello_mode == HELLO_TRICKLE) return;
+  Time hello = m_hello_interval.Update(changeDegree);
+
+  // pull the next hello forward when the neighbourhood starts moving again
+  if(hello < m_hello_message_timeout && m_hello_event.IsRunning() &&
+     Simulator::GetDelayLeft(m_hello_event) > hello) {
+    m_hello_event.Cancel();
+    m_hello_event = Simulator::Schedule(hello, &ecsClusterApp::ScheduleHello, this);
+  }
+  m_hello_message_timeout = hello;
 }
 
 void ecsClusterApp::RefreshInformationTable() {
-  std::list<InformationTableRow>::iterator it;
-  std::list<InformationTableRow> toDelete;
-  
-  if(m_informationTable.size()>0) {
-    if(GetStatus()==Node_Status::CLUSTER_HEAD) {
-    //std::cout << "CH IT size: " << m_informationTable.size() << "\n";
-    }
-    for (it = m_informationTable.begin(); it!=m_informationTable.end(); ++it) {
-      double gap_time = Simulator::Now().GetSeconds() - it->entryTime;
-      //std::cout << "entry time: " << it->entryTime << " current time: " << Simulator::Now().GetSeconds() << " valid entry: " << m_valid_entry_timeout.GetSeconds() << "\n";
-      if(gap_time > m_valid_entry_timeout.GetSeconds()) {
-        m_informationTable.erase(it++);
-      }
-    }
-  }
+  // rows sit on a timing wheel by expiry, only the buckets due since the last
+  // refresh are looked at
+  m_informationTable.Expire(Simulator::Now().GetSeconds());
 
   // if(m_informationTable.size()>0) {
   //   for(it = m_informationTable.begin(); it!= m_informationTable.end(); ++it) {
@@ -958,82 +1603,90 @@ void ecsClusterApp::CancelEventMap(std::map<uint64_t, EventId> events) {
 
 void ecsClusterApp::CheckCHShouldResign() {
   //information table = empty
-  bool can_resign = false;
   if(m_informationTable.size()<1) {
     //m_node_status = Node_Status::STANDALONE;
     SetStatus(Node_Status::STANDALONE);
   } else if(m_informationTable.size()+1<=5) {
     // <= 5 here seems suuuuuuper high for a network. Would like to check on higher/lower numbers to see impact
     // +1 because informationTable does not track self
-    std::list<InformationTableRow>::iterator it;
-    for(it = m_informationTable.begin(); it!= m_informationTable.end(); ++it) {
-      if(it->status == Node_Status::CLUSTER_GATEWAY) {
-        //If there is a cluster gateway to another cluster, I can resign and become a clusterguest through them!
-        can_resign=true;
-        break;
-      }
-    }
-    if(can_resign) {
+    //If there is a cluster gateway to another cluster, I can resign and become a clusterguest through them!
+    if(m_informationTable.Count(Node_Status::CLUSTER_GATEWAY) > 0) {
       //NS_LOG_UNCOND("\nResign sent from information table <=5 & gateway from " << GetID());
       //PrintCustomClusterTable();
-      m_node_status = Node_Status::CLUSTER_GUEST;
+      // Through SetStatus like every other change of status, not a plain
+      // assignment: a head that resigns has to drop its member index or
+      // GetClusterSize keeps counting the old cluster, the resignation is
+      // counted as a status change, and in Trickle mode the new status is
+      // an inconsistency neighbours should hear about soon.
+      SetStatus(Node_Status::CLUSTER_GUEST);
       SendResign(GenerateNodeStatusToUint());
     }
   }
 }
 
+// the information table keeps a count per status, none of these walk it
 uint64_t ecsClusterApp::GetNumHeadsCovering() {
-  uint64_t num_heads_covering=0;
-  std::list<InformationTableRow>::iterator it;
-  for(it = m_informationTable.begin(); it!=m_informationTable.end(); ++it) {
-    if(it->status == Node_Status::CLUSTER_HEAD) {
-      num_heads_covering++;
-    }
-  }
-  return num_heads_covering;
+  return m_informationTable.Count(Node_Status::CLUSTER_HEAD);
 }
 uint64_t ecsClusterApp::GetNumAccessPoints() {
-  uint64_t num_access_points=0;
-  std::list<InformationTableRow>::iterator it;
-  for(it = m_informationTable.begin(); it!=m_informationTable.end(); ++it) {
-    if(it->status == Node_Status::CLUSTER_MEMBER || it->status == Node_Status::CLUSTER_GATEWAY) {
-      num_access_points++;
-    }
+  return m_informationTable.Count(Node_Status::CLUSTER_MEMBER) +
+         m_informationTable.Count(Node_Status::CLUSTER_GATEWAY);
+}
+uint64_t ecsClusterApp::GetClusterSize() {
+  return m_members.GetSize();
+}
+
+// A neighbour that is new or whose status moved is a Trickle inconsistency, a
+// hello that repeats what is already known counts towards the redundancy
+void ecsClusterApp::UpsertNeighbor(const InformationTableRow& row, bool hello) {
+  const InformationTableRow* known = m_informationTable.Find(row.nodeID);
+  bool consistent = known != nullptr && known->status == row.status;
+  m_informationTable.Upsert(row);
+
+  if(m_hello_mode != HELLO_TRICKLE) return;
+  if(!consistent) {
+    ResetTrickle();
+  } else if(hello) {
+    m_trickle.Heard();
+  }
+}
+
+void ecsClusterApp::UpdateMembership(uint32_t nodeID, Node_Status status, const uint32_t* heads, size_t numHeads, double validTime) {
+  if(m_node_status != Node_Status::CLUSTER_HEAD) return;
+
+  // a member or gateway lists the heads it belongs to, anything else has left
+  bool joined = (status == Node_Status::CLUSTER_MEMBER || status == Node_Status::CLUSTER_GATEWAY) &&
+                std::find(heads, heads + numHeads, m_address) != heads + numHeads;
+  if(joined) {
+    m_members.Update(nodeID, m_address, heads, numHeads, Simulator::Now().GetSeconds(), validTime);
+  } else {
+    m_members.Leave(nodeID);
   }
-  return num_access_points;
 }
 
 void ecsClusterApp::CleanUp() { google::protobuf::ShutdownProtobufLibrary(); }
 
 void ecsClusterApp::PrintCustomClusterTable() {
-  std::list<InformationTableRow>::iterator it;
   NS_LOG_UNCOND("Printing custom cluster table for " << GetID() << " with size " << m_informationTable.size() << " at " << Simulator::Now().GetSeconds());
   NS_LOG_UNCOND(GetID() << " \t " << NodeStatusToStringFromTable(m_node_status));
-  for(it = m_informationTable.begin(); it != m_informationTable.end(); ++it) {
+  for (auto it = m_informationTable.begin(); it != m_informationTable.end(); ++it) {
     NS_LOG_UNCOND(it->nodeID << " \t " << NodeStatusToStringFromTable(it->status) << " \t " << (int)NodeStatusToUintFromTable(it->status));
   }
   NS_LOG_UNCOND("\n");
 
 }
 
+// the cluster head heard from most recently
 uint32_t ecsClusterApp::GetMemberClusterHeadsID() {
-  uint32_t chID = 0;
-  for (auto it = m_informationTable.begin(); it != m_informationTable.end(); ++it) {
-    if(it->status == Node_Status::CLUSTER_HEAD) {
-      chID = it->nodeID;
-    }
-  }
-  return chID;
+  InformationTableRow* head = m_informationTable.Last(Node_Status::CLUSTER_HEAD);
+  return head != nullptr ? head->nodeID : 0;
 }
 
-std::list<uint32_t> ecsClusterApp::GetGatewayClusterHeadIDs() {
-  std::list<uint32_t> chIDs;
-  for (auto it = m_informationTable.begin(); it != m_informationTable.end(); ++it) {
-    if(it->status == Node_Status::CLUSTER_HEAD) {
-      chIDs.push_back(it->nodeID);
-    }
+void ecsClusterApp::GetGatewayClusterHeadIDs(std::vector<uint32_t>& out) {
+  out.clear();
+  for (auto it = m_informationTable.begin(Node_Status::CLUSTER_HEAD); it != m_informationTable.end(); ++it) {
+    out.push_back(it->nodeID);
   }
-  return chIDs;
 }
 
 
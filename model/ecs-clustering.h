@@ -5,7 +5,9 @@
 #define APPLICATION_PORT 5000
 
 #include <map>
+#include <memory>
 #include <set> //std::set
+#include <vector>
 
 #include "ns3/application-container.h"
 #include "ns3/application.h"
@@ -14,32 +16,82 @@
 #include "ns3/callback.h"
 //#include "ns3/core-module.h"
 #include "ns3/event-id.h"
+#include "ns3/ipv4-header.h"
 #include "ns3/node-container.h"
 #include "ns3/object-base.h"
 #include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/socket.h"
 #include "ns3/uinteger.h"
 
+#include <google/protobuf/arena.h>
+
+#include "adaptive-interval.h"
+#include "cluster-membership.h"
+#include "duplicate-filter.h"
+#include "ecs-header.h"
+#include "information-table.h"
+#include "neighbor-oracle.h"
+#include "neighbor-source.h"
+#include "replay-window.h"
 #include "table.h"
+#include "trickle-timer.h"
 #include "ecs-stats.h"
 
 namespace ecs {
 
 using namespace ns3;
 
+namespace packets {
+class Message;
+}
+
 class ecsClusterApp : public Application {
   public:
     //unspec = 0, ch = 1, cm = 2, cgw = 3, sa = 4, cg = 5
     enum class Node_Status { UNSPECIFIED, CLUSTER_HEAD,
                       CLUSTER_MEMBER, CLUSTER_GATEWAY,
                       STANDALONE, CLUSTER_GUEST };
+    static const size_t NUM_NODE_STATUSES = 6;
     enum class State { NOT_STARTED = 0, RUNNING, STOPPED };
+    // How the neighbourhood and information table are kept up to date. POLL
+    // rescans every ScanInterval, EVENT rescans when a routing control message
+    // that adds or breaks a route within reach arrives, when an ECS message
+    // arrives or when an information table entry is due to expire, with a scan
+    // every SafetyScanInterval to catch anything missed, such as a neighbour
+    // loss only the node's own routing protocol notices.
+    enum class RefreshMode { POLL, EVENT };
+    // How stale information table rows are dropped. SWEEP expires them on
+    // every refresh, LAZY leaves them in place and skips them when read,
+    // compacting the table once enough of it is stale.
+    enum ExpiryMode { EXPIRY_SWEEP, EXPIRY_LAZY };
+    // How messages already received are recognised. WINDOW keeps an exact
+    // sliding window per sender, BLOOM a rotating Bloom filter of fixed size
+    // that may drop a new message now and then.
+    enum DedupeMode { DEDUPE_WINDOW, DEDUPE_BLOOM };
+    // How messages are encoded. PROTOBUF uses messages.proto, BINARY the
+    // fixed layout EcsHeader, which is smaller and needs no library calls.
+    enum WireFormat { WIRE_PROTOBUF, WIRE_BINARY };
+    // How hellos are paced. FIXED sends one every hello interval, TRICKLE
+    // doubles the interval while nothing changes and drops back to the
+    // minimum on a status change, a new neighbour or a cluster head change.
+    enum HelloMode { HELLO_FIXED, HELLO_TRICKLE };
 
     static TypeId GetTypeId();
     ecsClusterApp()
       : m_state(State::NOT_STARTED),
         m_node_status(Node_Status::UNSPECIFIED),
-        m_neighborhoodHops(1){};
+        m_neighborhoodHops(1),
+        m_refresh_mode(RefreshMode::POLL),
+        m_scanning(false),
+        m_expiry_mode(EXPIRY_SWEEP),
+        m_dedupe_mode(DEDUPE_WINDOW),
+        m_wire_format(WIRE_PROTOBUF),
+        m_hello_mode(HELLO_FIXED),
+        m_adaptive_timers(false),
+        m_message_sequence(0),
+        m_arena(ArenaBlockOptions(m_arena_block, sizeof(m_arena_block))),
+        m_draining(false){};
 
     struct InformationTableRow {
       uint32_t nodeID;
@@ -48,6 +100,8 @@ class ecsClusterApp : public Application {
       uint32_t clusterHeadID;
       uint32_t accessPointID;
       double entryTime;
+      // seconds the row stays valid without hearing from the node again
+      double validTime;
     };
 
     //implement these two
@@ -59,6 +113,9 @@ class ecsClusterApp : public Application {
 
 //local based vars & functions
   private:
+    // defined by the test suite, the one way its cases reach the app's state
+    friend class ecsClusterAppTestAccess;
+
     void StartApplication() override;
     void StopApplication() override;
 
@@ -68,6 +125,7 @@ class ecsClusterApp : public Application {
     Node_Status m_node_status;
     uint32_t m_neighborhoodHops;
     Time m_profileDelay;
+    uint16_t m_history_depth;
     Time m_standoff_time;
     Time random_m_standoff_time;
     Time m_inquiry_timeout;
@@ -75,6 +133,41 @@ class ecsClusterApp : public Application {
     Time m_hello_message_timeout;
     Time m_table_scan_timeout;
     Time m_valid_entry_timeout;
+    RefreshMode m_refresh_mode;
+    Time m_safety_scan_timeout;
+    Time m_refresh_holdoff;
+    bool m_scanning;
+    ExpiryMode m_expiry_mode;
+    double m_compaction_threshold;
+    DedupeMode m_dedupe_mode;
+    double m_filter_false_positive_rate;
+    uint32_t m_filter_memory;
+    WireFormat m_wire_format;
+    Time m_coalesce_window;
+    Time m_piggyback_delay;
+    HelloMode m_hello_mode;
+    Time m_trickle_imin;
+    Time m_trickle_imax;
+    uint32_t m_trickle_redundancy;
+    TrickleTimer m_trickle;
+    Ptr<UniformRandomVariable> m_trickle_offset;
+    // a hello is only suppressed while the last one sent keeps this node's
+    // rows until the end of the next interval
+    Time m_trickle_interval_end;
+    Time m_hello_covered_until;
+    Time m_max_valid_hello_interval;
+
+    bool m_adaptive_timers;
+    Time m_min_scan_interval;
+    Time m_max_scan_interval;
+    Time m_min_hello_interval;
+    Time m_max_hello_interval;
+    double m_change_smoothing;
+    Time m_change_window;
+    double m_low_change_degree;
+    double m_high_change_degree;
+    AdaptiveInterval m_scan_interval;
+    AdaptiveInterval m_hello_interval;
 
     Ptr<Socket> m_socket_recv;
     Ptr<Socket> m_neighborhood_socket;
@@ -90,7 +183,8 @@ class ecsClusterApp : public Application {
     void SendToNodes(Ptr<Packet> message, const std::set<uint32_t> nodes);
 
     Ptr<Packet> GeneratePing(uint8_t node_status);
-    Ptr<Packet> GenerateStatus(uint8_t node_status);
+    EcsHeader BuildPing(uint8_t node_status);
+    Ptr<Packet> GenerateStatus(uint8_t node_status, uint32_t recipient);
     Ptr<Packet> GenerateClusterHeadClaim();
     Ptr<Packet> GenerateMeeting();
     Ptr<Packet> GenerateResponse(uint64_t responseTo);
@@ -103,6 +197,8 @@ class ecsClusterApp : public Application {
     EventId m_print_table_event;
     EventId m_hello_event;
     EventId m_table_scan_event;
+    EventId m_refresh_event;
+    EventId m_trickle_event;
 
     void BroadcastToNeighbors(Ptr<Packet> packet);
     void SendMessage(Ipv4Address dest, Ptr<Packet> packet);
@@ -122,17 +218,34 @@ class ecsClusterApp : public Application {
     void ScheduleAverageRecording();
     void ScheduleScan();
     void ScheduleHello();
+    void StartTrickleInterval();
+    void EndTrickleInterval();
+    void TrickleHello();
+    void ResetTrickle();
+    void ScheduleRefresh(Time delay);
 
     void HandleRequest(Ptr<Socket> socket);
-    void HandlePing(uint32_t nodeID, uint8_t node_status);
+    void HandleLocalDeliver(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface);
+    void HandlePing(uint32_t nodeID, uint8_t node_status, Time helloInterval, const uint32_t* heads, size_t numHeads);
     void HandleClaim(uint32_t nodeID);
     void HandleResponse(uint32_t nodeID, uint8_t node_status);
     //create getNeighborhoodSize method
     void HandleMeeting(uint32_t nodeID, uint8_t node_status, uint64_t neighborhood_size);
     void HandleCHResign(uint32_t nodeID, uint8_t node_status);
-    void HandleStatus(uint32_t nodeId, uint8_t node_status);
+    void HandleStatus(uint32_t nodeId, uint8_t node_status, const uint32_t* heads, size_t numHeads);
+    void UpsertNeighbor(const InformationTableRow& row, bool hello);
+    void UpdateMembership(uint32_t nodeID, Node_Status status, const uint32_t* heads, size_t numHeads, double validTime);
 
     bool CheckDuplicateMessage(uint64_t messageID);
+    packets::Message* NewMessage();
+    Ptr<Packet> EncodeMessage(const EcsHeader& message);
+    bool DecodeFrame(Ptr<Packet> packet, std::vector<EcsHeader>& frame);
+    void AppendToFrame(Ptr<Packet> frame, Ptr<Packet> message);
+    void Transmit(uint32_t destination, Ptr<Packet> packet);
+    void QueueMessage(uint32_t destination, Ptr<Packet> packet);
+    void FlushOutbound();
+    void FlushPiggybacked();
+    void CheckPiggybackDeadline();
 
     uint8_t GenerateNodeStatusToUint();
     Node_Status GenerateStatusFromUint(uint8_t status);
@@ -140,14 +253,16 @@ class ecsClusterApp : public Application {
     uint64_t GenerateMessageID();
     std::string NodeStatusToStringFromTable(Node_Status status);
 
-    std::string GetRoutingTableString();
     void RefreshRoutingTable();
     void RefreshInformationTable();
+    void RefreshNeighborhood();
+    void AdaptTimers();
     void CheckCHShouldResign();
+    uint64_t GetClusterSize();
     uint64_t GetNumHeadsCovering();
     uint64_t GetNumAccessPoints();
     uint32_t GetMemberClusterHeadsID();
-    std::list<uint32_t> GetGatewayClusterHeadIDs();
+    void GetGatewayClusterHeadIDs(std::vector<uint32_t>& out);
 
     void CancelEventMap(std::map<uint64_t, EventId> events);
     void CancelEventMap(std::map<uint32_t, EventId> events);
@@ -156,11 +271,58 @@ class ecsClusterApp : public Application {
 
     uint32_t m_address;
     //std::map<uint32_t, std::pair<Node_Status, double>> m_informationTable;
-    std::list<InformationTableRow> m_informationTable;
-
-    std::set<uint64_t> m_received_messages;
+    // one row per neighbour, a newer message from a node overwrites its row
+    InformationTable<InformationTableRow, NUM_NODE_STATUSES> m_informationTable;
+    // the members and gateways of this node's cluster while it is a cluster head
+    ClusterMembership m_members;
+
+    // A hello as it goes on the wire for one node status, kept while the
+    // interval and heads it carries stay the same so a send only patches in
+    // the id and timestamp
+    struct HelloTemplate {
+      std::vector<uint8_t> bytes;
+      uint32_t helloInterval;
+      std::vector<uint32_t> heads;
+    };
+    bool IsHelloCurrent(const HelloTemplate& hello, uint8_t node_status);
+    HelloTemplate m_hello_templates[NUM_NODE_STATUSES];
+
+    // ids are this node's address and m_message_sequence, so they are unique
+    // without any state shared between nodes
+    uint32_t m_message_sequence;
+    ReplayWindow m_received_messages;
+    // only allocated when the DuplicateFilter attribute picks Bloom
+    std::unique_ptr<DuplicateFilter> m_duplicate_filter;
+
+    // received and generated messages are allocated here and released
+    // together, after each batch of received packets or after each send. The
+    // arena starts in m_arena_block and only takes blocks from the heap for a
+    // batch that outgrows it.
+    static const size_t ARENA_BLOCK_SIZE = 4096;
+    static google::protobuf::ArenaOptions ArenaBlockOptions(char* block, size_t size);
+    void ResetArena();
+    void CountArenaMessages(uint64_t messages);
+    alignas(8) char m_arena_block[ARENA_BLOCK_SIZE];
+    google::protobuf::Arena m_arena;
+    bool m_draining;
+    // the headers of the packet being handled, cleared but not freed between
+    // packets
+    std::vector<EcsHeader> m_frame;
+
+    // destination of a queued frame that goes to every neighbour
+    static const uint32_t BROADCAST = 0;
+    // frames are kept below the MTU of the 802.11 link
+    static const uint32_t MAX_FRAME_SIZE = 1400;
+    // frames waiting for the coalescing window to close, by destination
+    std::vector<std::pair<uint32_t, Ptr<Packet>>> m_outbound;
+    EventId m_flush_event;
+    // status replies waiting for the next hello, by the node they answer
+    std::vector<std::pair<uint32_t, Ptr<Packet>>> m_piggybacked;
 
     Table m_peerTable;
+    Ptr<NeighborSource> m_neighborSource;
+    Ptr<NeighborOracle> m_neighborOracle;
+    std::string m_routing_adapter;
 
     bool m_CH_Claim_flag;
 
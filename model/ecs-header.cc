@@ -0,0 +1,147 @@
+/// \file ecs-header.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "ecs-header.h"
+
+#include <algorithm>
+
+namespace ecs {
+
+NS_OBJECT_ENSURE_REGISTERED(EcsHeader);
+
+EcsHeader::EcsHeader()
+    : m_type(INVALID),
+      m_nodeStatus(0),
+      m_id(0),
+      m_timestamp(0),
+      m_helloInterval(0),
+      m_tableSize(0),
+      m_recipient(0),
+      m_numHeads(0) {}
+
+TypeId EcsHeader::GetTypeId() {
+  static TypeId id = TypeId("ecs-clustering:EcsHeader")
+                         .SetParent<Header>()
+                         .SetGroupName("Applications")
+                         .AddConstructor<EcsHeader>();
+  return id;
+}
+
+TypeId EcsHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+void EcsHeader::SetHelloInterval(uint32_t milliseconds) {
+  m_helloInterval = (uint16_t)std::min<uint32_t>(milliseconds, UINT16_MAX);
+}
+
+void EcsHeader::SetTableSize(uint64_t size) {
+  m_tableSize = (uint32_t)std::min<uint64_t>(size, UINT32_MAX);
+}
+
+void EcsHeader::AddHead(uint32_t head) {
+  if (m_numHeads < MAX_HEADS) {
+    m_heads[m_numHeads++] = head;
+    return;
+  }
+  if (m_numHeads == MAX_HEADS) m_moreHeads.assign(m_heads, m_heads + MAX_HEADS);
+  m_moreHeads.push_back(head);
+  m_numHeads++;
+}
+
+uint32_t EcsHeader::GetSerializedSize() const {
+  switch (m_type) {
+    case PING:
+      return FIXED_SIZE + 2 + 1 + 4 * NumSerializedHeads();
+    case STATUS:
+      return FIXED_SIZE + 4 + 1 + 4 * NumSerializedHeads();
+    case MEETING:
+      return FIXED_SIZE + 4;
+    default:
+      return FIXED_SIZE;
+  }
+}
+
+void EcsHeader::Serialize(Buffer::Iterator start) const {
+  Buffer::Iterator i = start;
+  i.WriteU8(m_type);
+  i.WriteU8(m_nodeStatus);
+  i.WriteHtonU64(m_id);
+  i.WriteHtonU32(m_timestamp);
+
+  if (m_type == PING) i.WriteHtonU16(m_helloInterval);
+  if (m_type == MEETING) i.WriteHtonU32(m_tableSize);
+  if (m_type == STATUS) i.WriteHtonU32(m_recipient);
+  if (m_type == PING || m_type == STATUS) {
+    size_t count = NumSerializedHeads();
+    i.WriteU8(count);
+    for (size_t h = 0; h < count; h++) {
+      i.WriteHtonU32(GetHeads()[h]);
+    }
+  }
+}
+
+// A truncated or unknown message leaves the type INVALID, whatever was read
+// is still reported so the packet can be dropped without asserting.
+uint32_t EcsHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  m_type = INVALID;
+  m_recipient = 0;
+  m_numHeads = 0;
+  if (i.GetRemainingSize() < FIXED_SIZE) return 0;
+
+  uint8_t type = i.ReadU8();
+  m_nodeStatus = i.ReadU8();
+  m_id = i.ReadNtohU64();
+  m_timestamp = i.ReadNtohU32();
+  if (type == INVALID || type > STATUS) return FIXED_SIZE;
+
+  if (type == PING) {
+    if (i.GetRemainingSize() < 2) return i.GetDistanceFrom(start);
+    m_helloInterval = i.ReadNtohU16();
+  }
+  if (type == MEETING) {
+    if (i.GetRemainingSize() < 4) return i.GetDistanceFrom(start);
+    m_tableSize = i.ReadNtohU32();
+  }
+  if (type == STATUS) {
+    if (i.GetRemainingSize() < 4) return i.GetDistanceFrom(start);
+    m_recipient = i.ReadNtohU32();
+  }
+  if (type == PING || type == STATUS) {
+    if (i.GetRemainingSize() < 1) return i.GetDistanceFrom(start);
+    uint8_t count = i.ReadU8();
+    if (count > MAX_HEADS || i.GetRemainingSize() < 4u * count) return i.GetDistanceFrom(start);
+    for (size_t h = 0; h < count; h++) {
+      m_heads[h] = i.ReadNtohU32();
+    }
+    m_numHeads = count;
+  }
+
+  m_type = (Type)type;
+  return i.GetDistanceFrom(start);
+}
+
+void EcsHeader::Print(std::ostream& os) const {
+  static const char* const names[] = {"Invalid", "Ping", "Inquiry", "Claim", "Meeting", "Resign", "Status"};
+  os << names[m_type] << " id=" << m_id << " status=" << (uint32_t)m_nodeStatus
+     << " time=" << m_timestamp << "ms";
+  if (m_type == PING) os << " hello=" << m_helloInterval << "ms";
+  if (m_type == MEETING) os << " tablesize=" << m_tableSize;
+  if (m_type == STATUS) os << " to=" << m_recipient;
+  for (size_t h = 0; h < m_numHeads; h++) {
+    os << (h == 0 ? " heads=" : ",") << GetHeads()[h];
+  }
+}
+
+}  // namespace ecs
@@ -0,0 +1,110 @@
+/// \file ecs-header.h
+/// \brief Fixed layout binary encoding of the ECS messages.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_HEADER_H
+#define __ECS_HEADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ostream>
+#include <vector>
+
+#include "ns3/header.h"
+
+namespace ecs {
+
+using namespace ns3;
+
+/// \brief Every ECS message as a packet header, an alternative to the
+///     protobuf encoding that needs no library calls to read or write.
+///
+///     type         1 byte, 0 when the header could not be read
+///     node status  1 byte
+///     id           8 bytes
+///     timestamp    4 bytes, milliseconds
+///
+/// followed by the payload of the type: a Ping has the hello interval in
+/// milliseconds as 2 bytes then a head list, a Status its recipient as 4
+/// bytes then a head list and a Meeting the sender's cluster size as 4 bytes.
+/// A head list is a count byte and 4 bytes per head, at most MAX_HEADS of
+/// them, the header itself holds any number for the protobuf encoding to
+/// carry. The first MAX_HEADS are kept inside the header, so decoding one
+/// does not allocate. Multi-byte fields are in
+/// network order. Headers are self delimiting, so a frame of several
+/// messages is just one header after another.
+class EcsHeader : public Header {
+ public:
+  enum Type { INVALID, PING, INQUIRY, CLAIM, MEETING, RESIGN, STATUS };
+
+  /// \brief Heads the binary encoding of a Ping or Status carries, any
+  ///     beyond this are left out of it.
+  static const size_t MAX_HEADS = 16;
+  /// \brief Size of the fields every message has.
+  static const uint32_t FIXED_SIZE = 14;
+
+  EcsHeader();
+
+  static TypeId GetTypeId();
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+  Type GetType() const { return m_type; }
+  void SetType(Type type) { m_type = type; }
+  uint8_t GetNodeStatus() const { return m_nodeStatus; }
+  void SetNodeStatus(uint8_t status) { m_nodeStatus = status; }
+  uint64_t GetId() const { return m_id; }
+  void SetId(uint64_t id) { m_id = id; }
+  uint32_t GetTimestamp() const { return m_timestamp; }
+  void SetTimestamp(uint32_t milliseconds) { m_timestamp = milliseconds; }
+
+  /// \brief Ping only, milliseconds, saturates at 65535.
+  uint32_t GetHelloInterval() const { return m_helloInterval; }
+  void SetHelloInterval(uint32_t milliseconds);
+  /// \brief Meeting only.
+  uint32_t GetTableSize() const { return m_tableSize; }
+  void SetTableSize(uint64_t size);
+  /// \brief Status only, the node it answers or 0 when it is for anyone.
+  uint32_t GetRecipient() const { return m_recipient; }
+  void SetRecipient(uint32_t recipient) { m_recipient = recipient; }
+
+  /// \brief Ping and Status only.
+  void AddHead(uint32_t head);
+  const uint32_t* GetHeads() const { return m_numHeads > MAX_HEADS ? m_moreHeads.data() : m_heads; }
+  size_t GetNumHeads() const { return m_numHeads; }
+
+ private:
+  size_t NumSerializedHeads() const { return m_numHeads < MAX_HEADS ? m_numHeads : MAX_HEADS; }
+
+  Type m_type;
+  uint8_t m_nodeStatus;
+  uint64_t m_id;
+  uint32_t m_timestamp;
+  uint16_t m_helloInterval;
+  uint32_t m_tableSize;
+  uint32_t m_recipient;
+  size_t m_numHeads;
+  uint32_t m_heads[MAX_HEADS];
+  // every head once there are more than MAX_HEADS
+  std::vector<uint32_t> m_moreHeads;
+};
+
+}  // namespace ecs
+
+#endif
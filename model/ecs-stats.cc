@@ -22,6 +22,21 @@ static uint64_t claims;
 static uint64_t statuses;
 static uint64_t meetings;
 static uint64_t resigns;
+static uint64_t scans;
+static double filterOccupancy;
+static uint64_t filterSamples;
+static double filterFalseDrops;
+static uint64_t arenaResets;
+static uint64_t arenaBytesUsed;
+static uint64_t arenaHeapResets;
+static uint64_t arenaHeapBytes;
+static uint64_t arenaMessages;
+static uint64_t arenaHeapMessages;
+static uint64_t coalescedMessages;
+static uint64_t controlBytes;
+static uint64_t suppressedHellos;
+static uint64_t trickleResets;
+static uint64_t statusChanges;
 
 static std::list<CH_Event> CH_Event_List;
 static std::list<Member_Event> Membership_List;
@@ -67,6 +82,21 @@ void Stats::Reset() {
   statuses = 0;
   meetings = 0;
   resigns = 0;
+  scans = 0;
+  filterOccupancy = 0;
+  filterSamples = 0;
+  filterFalseDrops = 0;
+  arenaResets = 0;
+  arenaBytesUsed = 0;
+  arenaHeapResets = 0;
+  arenaHeapBytes = 0;
+  arenaMessages = 0;
+  arenaHeapMessages = 0;
+  coalescedMessages = 0;
+  controlBytes = 0;
+  suppressedHellos = 0;
+  trickleResets = 0;
+  statusChanges = 0;
 }
 
 void Stats::incPing() { pings++; }
@@ -74,6 +104,46 @@ void Stats::incClaim() { claims++; }
 void Stats::incStatus() { statuses++; }
 void Stats::incMeeting() { meetings++; }
 void Stats::incResign() { resigns++; }
+void Stats::incScan() { scans++; }
+
+void Stats::IncreaseFilterOccupancy(double occupancy) {
+  filterOccupancy += occupancy;
+  filterSamples++;
+}
+void Stats::IncreaseFilterFalseDrops(double false_drops) {
+  filterFalseDrops += false_drops;
+}
+// what one batch of messages used, and the blocks it took from the heap
+// beyond the arena's initial block
+void Stats::RecordArenaReset(uint64_t used, uint64_t heap_bytes) {
+  arenaResets++;
+  arenaBytesUsed += used;
+  arenaHeapResets += heap_bytes > 0;
+  arenaHeapBytes += heap_bytes;
+}
+// messages built on an arena instead of the heap, and how many of them only
+// fit once the arena had taken a block from the heap
+void Stats::RecordArenaMessages(uint64_t messages, bool heap) {
+  arenaMessages += messages;
+  if (heap) arenaHeapMessages += messages;
+}
+// a message that went out inside another one's frame instead of its own
+void Stats::IncreaseCoalescedMessages() {
+  coalescedMessages++;
+}
+
+void Stats::IncreaseControlBytes(uint32_t bytes) {
+  controlBytes += bytes;
+}
+void Stats::IncreaseSuppressedHellos() {
+  suppressedHellos++;
+}
+void Stats::IncreaseTrickleResets() {
+  trickleResets++;
+}
+void Stats::IncreaseStatusChanges() {
+  statusChanges++;
+}
 
 void Stats::PrintMessageTotals() {
   std::cout << "Pings:\t" << pings << "\n";
@@ -81,6 +151,39 @@ void Stats::PrintMessageTotals() {
   std::cout << "Statuses:\t" << statuses << "\n";
   std::cout << "Meetings:\t" << meetings << "\n";
   std::cout << "resigns:\t" << resigns << "\n";
+  std::cout << "Scans:\t" << scans << "\n";
+  std::cout << "Coalesced:\t" << coalescedMessages << "\n";
+  if (filterSamples > 0) {
+    std::cout << "Filter_Occupancy:\t" << filterOccupancy / filterSamples << "\n";
+    std::cout << "Filter_Est_False_Drops:\t" << filterFalseDrops << "\n";
+  }
+}
+
+// how many messages the arenas built and how much they held per batch, and
+// how often and how much a batch outgrew the initial block over the measured
+// seconds
+void Stats::PrintAllocationRate(double seconds) {
+  std::cout << "Arena_Messages:\t" << arenaMessages << "\n";
+  std::cout << "Arena_Messages_Per_Sec:\t" << arenaMessages / seconds << "\n";
+  std::cout << "Arena_Heap_Messages:\t" << arenaHeapMessages << "\n";
+  std::cout << "Arena_Heap_Messages_Per_Sec:\t" << arenaHeapMessages / seconds << "\n";
+  std::cout << "Arena_Resets:\t" << arenaResets << "\n";
+  if (arenaResets > 0) {
+    std::cout << "Arena_Bytes_Per_Reset:\t" << (double)arenaBytesUsed / arenaResets << "\n";
+  }
+  std::cout << "Arena_Heap_Resets:\t" << arenaHeapResets << "\n";
+  std::cout << "Arena_Heap_Bytes_Per_Sec:\t" << arenaHeapBytes / seconds << "\n";
+}
+
+// control overhead and how often nodes changed role over the measured
+// seconds, per node so runs with different node counts compare
+void Stats::PrintControlRate(double seconds, uint16_t num_nodes) {
+  std::cout << "Control_Bytes:\t" << controlBytes << "\n";
+  std::cout << "Control_Bytes_Per_Sec:\t" << controlBytes / seconds << "\n";
+  std::cout << "Control_Bytes_Per_Node_Sec:\t" << controlBytes / seconds / num_nodes << "\n";
+  std::cout << "Hellos_Suppressed:\t" << suppressedHellos << "\n";
+  std::cout << "Trickle_Resets:\t" << trickleResets << "\n";
+  std::cout << "Status_Changes_Per_Node_Min:\t" << statusChanges / (seconds / 60) / num_nodes << "\n";
 }
 
 void Stats::IncreaseClusterChangeMessages() {
@@ -74,6 +74,18 @@ class Stats {
         void incStatus();
         void incMeeting();
         void incResign();
+        void incScan();
+        void IncreaseFilterOccupancy(double occupancy);
+        void IncreaseFilterFalseDrops(double false_drops);
+        void RecordArenaReset(uint64_t used, uint64_t heap_bytes);
+        void RecordArenaMessages(uint64_t messages, bool heap);
+        void IncreaseCoalescedMessages();
+        void PrintAllocationRate(double seconds);
+        void IncreaseControlBytes(uint32_t bytes);
+        void IncreaseSuppressedHellos();
+        void IncreaseTrickleResets();
+        void IncreaseStatusChanges();
+        void PrintControlRate(double seconds, uint16_t num_nodes);
         
         void PrintMessageTotals();
 
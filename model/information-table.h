@@ -0,0 +1,549 @@
+/// \file information-table.h
+/// \brief Information table rows indexed by node id.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_INFORMATION_TABLE_H
+#define __ECS_INFORMATION_TABLE_H
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace ecs {
+
+/// \brief Rows keyed by their nodeID, at most one row per node. Rows live in
+///     slots that keep their index until the row is erased, freed slots are
+///     reused. An open addressing index maps a node id to its slot, and the
+///     slots are linked in the order they were last written so the table can
+///     be walked and erased from while walking. Each status also keeps its
+///     own list and count, so the rows with one status can be counted or
+///     walked without touching the others. Rows are also hung on a hashed
+///     timing wheel by the time they expire, so expiring the table only looks
+///     at the buckets whose ticks have passed, or expiry can be left to the
+///     readers with SetLazyExpiry.
+///
+///     The slots are stored as parallel columns. The id, status and expiry of
+///     every slot sit in their own arrays so the lookups, counts and sweeps
+///     stream over a few bytes per row, the full rows and the list links are
+///     only touched when a row is read or written. Expiry is resolved to the
+///     millisecond. Row needs a uint32_t nodeID, a status that converts to an
+///     index below STATUSES, and double entryTime and validTime in seconds.
+///     The columns are copied from the row by Upsert, so those four fields
+///     are only changed through Upsert and not through a returned row.
+template <typename Row, size_t STATUSES>
+class InformationTable {
+  static_assert(STATUSES < UINT8_MAX, "statuses are stored in a byte");
+
+  struct Links {
+    uint32_t prev;
+    uint32_t next;
+  };
+
+  struct SlotLinks {
+    Links all;
+    Links byStatus;
+    Links byExpiry;
+    uint64_t expiryTick;
+  };
+
+  struct List {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t size;
+  };
+
+  typedef Links SlotLinks::*LinksMember;
+
+  // status column value of a slot on the free list
+  static constexpr uint8_t FREE = STATUSES;
+
+ public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  /// \brief Walks the live rows, with lazy expiry the stale rows it steps
+  ///     over are marked for compaction.
+  class iterator {
+   public:
+    iterator(InformationTable* table, uint32_t slot, LinksMember links)
+        : m_table(table), m_links(links), m_now(table->NowMs()) {
+      m_slot = m_table->SkipStale(slot, m_links, m_now);
+    }
+
+    Row& operator*() const { return m_table->m_rows[m_slot]; }
+    Row* operator->() const { return &m_table->m_rows[m_slot]; }
+    iterator& operator++() {
+      m_slot = m_table->SkipStale((m_table->m_links[m_slot].*m_links).next, m_links, m_now);
+      return *this;
+    }
+    bool operator==(const iterator& other) const { return m_slot == other.m_slot; }
+    bool operator!=(const iterator& other) const { return m_slot != other.m_slot; }
+
+   private:
+    friend class InformationTable;
+    InformationTable* m_table;
+    uint32_t m_slot;
+    LinksMember m_links;
+    uint32_t m_now;
+  };
+
+  /// \brief tick is the wheel resolution in seconds and buckets the number
+  ///     of ticks in one turn of the wheel, a power of two. Rows that expire
+  ///     more than a turn ahead wait in their bucket for later turns.
+  explicit InformationTable(double tick = 0.1, size_t buckets = 64)
+      : m_shift(29),
+        m_index(8, 0),
+        m_tickMs(std::max<uint32_t>(1, ToMs(tick))),
+        m_wheel(buckets),
+        m_expiredTick(0),
+        m_clock(nullptr),
+        m_compactAt(1),
+        m_numBuried(0),
+        m_buriedByStatus() {
+    m_all = EmptyList();
+    for (size_t s = 0; s < STATUSES; s++) m_byStatus[s] = EmptyList();
+    for (size_t b = 0; b < buckets; b++) m_wheel[b] = EmptyList();
+  }
+
+  /// \brief Leave expiry to the readers. Every read checks the rows it
+  ///     touches against clock() and skips the stale ones as if they had been
+  ///     erased, so Expire never has to be called. A stale row is only marked
+  ///     when a read finds it, once the marked rows pass compactAt of the
+  ///     table the next Upsert reclaims every stale row in one pass. Counts
+  ///     and size stay exact as the marked rows are counted out by status,
+  ///     they first mark the rows in the wheel buckets due since they last
+  ///     looked.
+  void SetLazyExpiry(double (*clock)(), double compactAt) {
+    m_clock = clock;
+    m_compactAt = compactAt;
+  }
+
+  /// \brief Number of rows marked stale and not yet reclaimed.
+  size_t GetNumBuried() const { return m_numBuried; }
+
+  size_t size() {
+    if (m_clock == nullptr) return m_all.size;
+    BuryExpired(NowMs());
+    return m_all.size - m_numBuried;
+  }
+  bool empty() { return size() == 0; }
+
+  iterator begin() { return iterator(this, m_all.head, &SlotLinks::all); }
+  iterator end() { return iterator(this, NONE, &SlotLinks::all); }
+
+  /// \brief Walk only the rows with the given status, end() ends the walk.
+  template <typename Status>
+  iterator begin(Status status) {
+    return iterator(this, m_byStatus[static_cast<size_t>(status)].head, &SlotLinks::byStatus);
+  }
+
+  /// \brief Number of rows with the given status.
+  template <typename Status>
+  size_t Count(Status status) {
+    size_t s = static_cast<size_t>(status);
+    if (m_clock == nullptr) return m_byStatus[s].size;
+    BuryExpired(NowMs());
+    return m_byStatus[s].size - m_buriedByStatus[s];
+  }
+
+  /// \brief Count the rows still valid at now by status, in one pass over
+  ///     the status and expiry columns whatever the expiry mode.
+  void Census(double now, size_t counts[STATUSES]) const {
+    uint32_t nowMs = ToMs(now);
+    uint32_t histogram[STATUSES + 1] = {};
+    for (size_t i = 0; i < m_statuses.size(); i++) {
+      histogram[m_statuses[i]] += nowMs <= m_expiries[i];
+    }
+    for (size_t s = 0; s < STATUSES; s++) counts[s] = histogram[s];
+  }
+
+  /// \brief The most recently written row with the given status, or nullptr.
+  template <typename Status>
+  Row* Last(Status status) {
+    uint32_t now = NowMs();
+    uint32_t slot = m_byStatus[static_cast<size_t>(status)].tail;
+    while (slot != NONE && IsStale(slot, now)) {
+      Bury(slot);
+      slot = m_links[slot].byStatus.prev;
+    }
+    return slot == NONE ? nullptr : &m_rows[slot];
+  }
+
+  /// \brief The row for id, or nullptr when there is none.
+  Row* Find(uint32_t id) {
+    uint32_t slot = m_index[Lookup(id)];
+    if (slot == 0) return nullptr;
+    if (IsStale(slot - 1, NowMs())) {
+      Bury(slot - 1);
+      return nullptr;
+    }
+    return &m_rows[slot - 1];
+  }
+  const Row* Find(uint32_t id) const {
+    uint32_t slot = m_index[Lookup(id)];
+    return slot == 0 || IsStale(slot - 1, NowMs()) ? nullptr : &m_rows[slot - 1];
+  }
+
+  /// \brief Write row over the one with the same nodeID, adding it when the
+  ///     node is not in the table. Either way it becomes the last row walked.
+  ///     References to rows are invalidated when a new row is added.
+  Row& Upsert(const Row& row) {
+    if (m_numBuried > 0 && m_numBuried >= m_compactAt * m_all.size) Compact();
+
+    size_t pos = Lookup(row.nodeID);
+    uint32_t slot;
+
+    if (m_index[pos] != 0) {
+      slot = m_index[pos] - 1;
+      Unlink(slot);
+      Unbury(slot);
+    } else {
+      if (IsIndexFull()) {
+        Rehash(m_index.size() * 2);
+        pos = Lookup(row.nodeID);
+      }
+      if (!m_free.empty()) {
+        slot = m_free.back();
+        m_free.pop_back();
+      } else {
+        slot = m_rows.size();
+        m_ids.push_back(0);
+        m_statuses.push_back(FREE);
+        m_expiries.push_back(0);
+        m_buried.push_back(0);
+        m_rows.push_back(Row());
+        m_links.push_back(SlotLinks());
+      }
+      m_index[pos] = slot + 1;
+    }
+
+    m_ids[slot] = row.nodeID;
+    m_statuses[slot] = static_cast<uint8_t>(row.status);
+    m_expiries[slot] = ToMs(ExpiryOf(row));
+    m_buried[slot] = 0;
+    m_rows[slot] = row;
+    Link(slot);
+    return m_rows[slot];
+  }
+
+  /// \brief Remove the row for id, false when there was none.
+  bool Erase(uint32_t id) {
+    size_t pos = Lookup(id);
+    if (m_index[pos] == 0) return false;
+    Remove(pos);
+    return true;
+  }
+
+  /// \brief Remove the row it points at and return the next row of the same walk.
+  iterator Erase(iterator it) {
+    uint32_t next = (m_links[it.m_slot].*it.m_links).next;
+    Remove(Lookup(m_ids[it.m_slot]));
+    return iterator(this, next, it.m_links);
+  }
+
+  void Clear() {
+    m_ids.clear();
+    m_statuses.clear();
+    m_expiries.clear();
+    m_buried.clear();
+    m_rows.clear();
+    m_links.clear();
+    m_free.clear();
+    std::fill(m_index.begin(), m_index.end(), 0);
+    m_all = EmptyList();
+    for (size_t s = 0; s < STATUSES; s++) m_byStatus[s] = EmptyList();
+    for (size_t b = 0; b < m_wheel.size(); b++) m_wheel[b] = EmptyList();
+    m_numBuried = 0;
+    std::fill(m_buriedByStatus, m_buriedByStatus + STATUSES, 0);
+  }
+
+  /// \brief Erase every row that is no longer valid at now, found by one pass
+  ///     over the expiry column rather than by following the lists.
+  size_t Sweep(double now) {
+    uint32_t nowMs = ToMs(now);
+    size_t slots = m_expiries.size();
+    m_scratch.resize(slots);
+
+    // append every stale slot without branching, free slots never qualify
+    size_t stale = 0;
+    for (size_t i = 0; i < slots; i++) {
+      m_scratch[stale] = i;
+      stale += (nowMs > m_expiries[i]) & (m_statuses[i] != FREE);
+    }
+    for (size_t i = 0; i < stale; i++) {
+      Remove(Lookup(m_ids[m_scratch[i]]));
+    }
+    return stale;
+  }
+
+  /// \brief Erase every stale row, marked or not, in one pass.
+  void Compact() { Sweep(m_clock != nullptr ? m_clock() : 0); }
+
+  /// \brief Erase every row that has gone longer than its validTime without
+  ///     being written, as of now. Only the buckets of the ticks since the
+  ///     last call are visited, the current tick is kept for the next call
+  ///     as its rows may still be valid. Returns the number of rows erased.
+  size_t Expire(double now) {
+    return Expire(now, [](const Row&) {});
+  }
+
+  /// \brief Expire that hands every row to onExpire just before it is erased.
+  template <typename F>
+  size_t Expire(double now, F onExpire) {
+    uint32_t nowMs = ToMs(now);
+    uint64_t nowTick = nowMs / m_tickMs;
+    uint64_t mask = m_wheel.size() - 1;
+    uint64_t from = m_expiredTick;
+    // after a long gap every bucket is visited once
+    if (nowTick - from > mask) from = nowTick - mask;
+
+    size_t expired = 0;
+    for (uint64_t tick = from; tick <= nowTick; tick++) {
+      uint32_t slot = m_wheel[tick & mask].head;
+      while (slot != NONE) {
+        uint32_t next = m_links[slot].byExpiry.next;
+        if (nowMs > m_expiries[slot]) {
+          onExpire(m_rows[slot]);
+          Remove(Lookup(m_ids[slot]));
+          expired++;
+        }
+        slot = next;
+      }
+    }
+    m_expiredTick = std::max(m_expiredTick, nowTick);
+    return expired;
+  }
+
+  /// \brief The earliest entryTime + validTime in the table, DBL_MAX when
+  ///     it is empty. Looks through the buckets in tick order and stops at
+  ///     the first one holding a row due in this turn of the wheel.
+  double NextExpiry() const {
+    if (m_all.size == 0) return DBL_MAX;
+    uint64_t mask = m_wheel.size() - 1;
+    for (uint64_t tick = m_expiredTick; tick <= m_expiredTick + mask; tick++) {
+      double earliest = DBL_MAX;
+      for (uint32_t slot = m_wheel[tick & mask].head; slot != NONE; slot = m_links[slot].byExpiry.next) {
+        if (m_links[slot].expiryTick != tick) continue;
+        earliest = std::min(earliest, ExpiryOf(m_rows[slot]));
+      }
+      if (earliest != DBL_MAX) return earliest;
+    }
+
+    // everything is at least a turn away
+    double earliest = DBL_MAX;
+    for (uint32_t slot = m_all.head; slot != NONE; slot = m_links[slot].all.next) {
+      earliest = std::min(earliest, ExpiryOf(m_rows[slot]));
+    }
+    return earliest;
+  }
+
+  /// \brief Fill out with the id of every row in ascending order.
+  void GetIds(std::vector<uint32_t>& out) const {
+    out.clear();
+    uint32_t now = NowMs();
+    for (uint32_t slot = 0; slot < m_ids.size(); slot++) {
+      if (m_statuses[slot] != FREE && !IsStale(slot, now)) out.push_back(m_ids[slot]);
+    }
+    std::sort(out.begin(), out.end());
+  }
+
+ private:
+  static List EmptyList() { return List{NONE, NONE, 0}; }
+
+  static double ExpiryOf(const Row& row) { return row.entryTime + row.validTime; }
+
+  static uint32_t ToMs(double seconds) {
+    if (seconds <= 0) return 0;
+    if (seconds >= UINT32_MAX / 1000.0) return UINT32_MAX;
+    return (uint32_t)llround(seconds * 1000);
+  }
+
+  uint32_t NowMs() const { return m_clock != nullptr ? ToMs(m_clock()) : 0; }
+
+  // only rows already marked are stale unless expiry is lazy
+  bool IsStale(uint32_t slot, uint32_t now) const {
+    return m_buried[slot] || (m_clock != nullptr && now > m_expiries[slot]);
+  }
+
+  void Bury(uint32_t slot) {
+    if (m_buried[slot]) return;
+    m_buried[slot] = 1;
+    m_numBuried++;
+    m_buriedByStatus[m_statuses[slot]]++;
+  }
+
+  // count a marked slot back out before it is freed or overwritten
+  void Unbury(uint32_t slot) {
+    if (!m_buried[slot]) return;
+    m_buried[slot] = 0;
+    m_numBuried--;
+    m_buriedByStatus[m_statuses[slot]]--;
+  }
+
+  // the first live row from slot on along links
+  uint32_t SkipStale(uint32_t slot, LinksMember links, uint32_t now) {
+    while (slot != NONE && IsStale(slot, now)) {
+      Bury(slot);
+      slot = (m_links[slot].*links).next;
+    }
+    return slot;
+  }
+
+  // Mark the rows that went stale in the buckets since the last look, the
+  // same walk as Expire but the rows stay in place for the next compaction.
+  void BuryExpired(uint32_t nowMs) {
+    uint64_t nowTick = nowMs / m_tickMs;
+    uint64_t mask = m_wheel.size() - 1;
+    uint64_t from = m_expiredTick;
+    if (nowTick - from > mask) from = nowTick - mask;
+
+    for (uint64_t tick = from; tick <= nowTick; tick++) {
+      for (uint32_t slot = m_wheel[tick & mask].head; slot != NONE; slot = m_links[slot].byExpiry.next) {
+        if (nowMs > m_expiries[slot]) Bury(slot);
+      }
+    }
+    m_expiredTick = std::max(m_expiredTick, nowTick);
+  }
+
+  // Fibonacci hashing, node ids are IPv4 addresses that only differ in the low bits
+  size_t Home(uint32_t id) const { return (id * 2654435769u) >> m_shift; }
+
+  // position of id in the index, or of the empty entry where it would go
+  size_t Lookup(uint32_t id) const {
+    size_t mask = m_index.size() - 1;
+    size_t pos = Home(id);
+    while (m_index[pos] != 0 && m_ids[m_index[pos] - 1] != id) {
+      pos = (pos + 1) & mask;
+    }
+    return pos;
+  }
+
+  // keep the index at most three quarters full
+  bool IsIndexFull() const { return (m_all.size + 1) * 4 > m_index.size() * 3; }
+
+  void Rehash(size_t capacity) {
+    m_index.assign(capacity, 0);
+    m_shift--;
+    size_t mask = capacity - 1;
+    for (uint32_t slot = m_all.head; slot != NONE; slot = m_links[slot].all.next) {
+      size_t pos = Home(m_ids[slot]);
+      while (m_index[pos] != 0) pos = (pos + 1) & mask;
+      m_index[pos] = slot + 1;
+    }
+  }
+
+  // Empty the index entry at pos by shifting the rest of its probe run back,
+  // so lookups never have to step over deleted markers.
+  void Remove(size_t pos) {
+    uint32_t slot = m_index[pos] - 1;
+    Unlink(slot);
+    m_free.push_back(slot);
+    Unbury(slot);
+    m_statuses[slot] = FREE;
+
+    size_t mask = m_index.size() - 1;
+    size_t hole = pos;
+    for (size_t next = (pos + 1) & mask; m_index[next] != 0; next = (next + 1) & mask) {
+      size_t home = Home(m_ids[m_index[next] - 1]);
+      // an entry can fill the hole unless its home lies between the hole and it
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        m_index[hole] = m_index[next];
+        hole = next;
+      }
+    }
+    m_index[hole] = 0;
+  }
+
+  void Link(uint32_t slot) {
+    Append(m_all, &SlotLinks::all, slot);
+    Append(m_byStatus[m_statuses[slot]], &SlotLinks::byStatus, slot);
+
+    // a row that is already stale goes in the bucket the next Expire looks at first
+    uint64_t tick = std::max<uint64_t>(m_expiries[slot] / m_tickMs, m_expiredTick);
+    m_links[slot].expiryTick = tick;
+    Append(m_wheel[tick & (m_wheel.size() - 1)], &SlotLinks::byExpiry, slot);
+  }
+
+  void Unlink(uint32_t slot) {
+    Detach(m_all, &SlotLinks::all, slot);
+    Detach(m_byStatus[m_statuses[slot]], &SlotLinks::byStatus, slot);
+    Detach(m_wheel[m_links[slot].expiryTick & (m_wheel.size() - 1)], &SlotLinks::byExpiry, slot);
+  }
+
+  void Append(List& list, LinksMember member, uint32_t slot) {
+    Links& links = m_links[slot].*member;
+    links.prev = list.tail;
+    links.next = NONE;
+    if (list.tail != NONE) {
+      (m_links[list.tail].*member).next = slot;
+    } else {
+      list.head = slot;
+    }
+    list.tail = slot;
+    list.size++;
+  }
+
+  void Detach(List& list, LinksMember member, uint32_t slot) {
+    Links& links = m_links[slot].*member;
+    if (links.prev != NONE) {
+      (m_links[links.prev].*member).next = links.next;
+    } else {
+      list.head = links.next;
+    }
+    if (links.next != NONE) {
+      (m_links[links.next].*member).prev = links.prev;
+    } else {
+      list.tail = links.prev;
+    }
+    list.size--;
+  }
+
+  // one entry per slot in every column, a free slot has status FREE
+  std::vector<uint32_t> m_ids;
+  std::vector<uint8_t> m_statuses;
+  // entryTime + validTime in milliseconds
+  std::vector<uint32_t> m_expiries;
+  // found stale by a lazy read, waiting for the next compaction
+  std::vector<uint8_t> m_buried;
+  std::vector<Row> m_rows;
+  std::vector<SlotLinks> m_links;
+
+  std::vector<uint32_t> m_free;
+  std::vector<uint32_t> m_scratch;
+  List m_all;
+  List m_byStatus[STATUSES];
+
+  // slot + 1 for each node, 0 marks an empty entry, the size is a power of two
+  uint32_t m_shift;
+  std::vector<uint32_t> m_index;
+
+  // m_expiredTick is the oldest tick whose bucket may still hold a stale row
+  // that is neither erased nor marked
+  uint32_t m_tickMs;
+  std::vector<List> m_wheel;
+  uint64_t m_expiredTick;
+
+  double (*m_clock)();
+  double m_compactAt;
+  uint32_t m_numBuried;
+  uint32_t m_buriedByStatus[STATUSES];
+};
+
+}  // namespace ecs
+
+#endif
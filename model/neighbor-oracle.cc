@@ -0,0 +1,212 @@
+/// \file neighbor-oracle.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "neighbor-oracle.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "ns3/double.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ecs {
+
+NS_LOG_COMPONENT_DEFINE("EcsNeighborOracle");
+NS_OBJECT_ENSURE_REGISTERED(NeighborOracle);
+
+TypeId NeighborOracle::GetTypeId() {
+  static TypeId id = TypeId("ecs-clustering:NeighborOracle")
+                         .SetParent<Object>()
+                         .SetGroupName("Applications")
+                         .AddConstructor<NeighborOracle>()
+                         .AddAttribute(
+                             "Range",
+                             "Radius of connectivity in meters",
+                             DoubleValue(250.0),
+                             MakeDoubleAccessor(&NeighborOracle::m_range),
+                             MakeDoubleChecker<double>(0.0))
+                         .AddAttribute(
+                             "UpdateInterval",
+                             "How long node positions are reused before the grid is rebuilt",
+                             TimeValue(Seconds(0.1)),
+                             MakeTimeAccessor(&NeighborOracle::m_updateInterval),
+                             MakeTimeChecker());
+  return id;
+}
+
+NeighborOracle::NeighborOracle()
+    : m_range(250.0), m_built(false), m_resolved(false), m_bucketMask(0), m_graphBuilt(false) {}
+
+void NeighborOracle::Add(NodeContainer nodes) {
+  for (uint32_t i = 0; i < nodes.GetN(); i++) {
+    Add(nodes.Get(i));
+  }
+}
+
+void NeighborOracle::Add(Ptr<Node> node) {
+  Ptr<MobilityModel> mobility = node->GetObject<MobilityModel>();
+  if (mobility == 0) {
+    NS_FATAL_ERROR("NeighborOracle needs a MobilityModel on every node");
+  }
+  m_nodes.push_back(node);
+  m_mobility.push_back(mobility);
+  m_resolved = false;
+  m_built = false;
+}
+
+// The apps identify nodes by their IPv4 address, which is usually assigned
+// after the nodes are handed to the oracle
+void NeighborOracle::ResolveIds() {
+  m_ids.resize(m_nodes.size());
+  m_index.clear();
+  m_index.reserve(m_nodes.size());
+  for (uint32_t i = 0; i < m_nodes.size(); i++) {
+    Ptr<Ipv4> ipv4 = m_nodes[i]->GetObject<Ipv4>();
+    m_ids[i] = ipv4 == 0 ? 0 : ipv4->GetAddress(1, 0).GetLocal().Get();
+    m_index[m_ids[i]] = i;
+  }
+  m_resolved = true;
+}
+
+uint32_t NeighborOracle::Bucket(int64_t cx, int64_t cy) const {
+  uint32_t h = (uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u;
+  return h & m_bucketMask;
+}
+
+void NeighborOracle::Update() {
+  if (!m_resolved) ResolveIds();
+  if (m_built && Simulator::Now() - m_builtAt < m_updateInterval) return;
+  Rebuild();
+}
+
+void NeighborOracle::Rebuild() {
+  uint32_t n = m_nodes.size();
+
+  // about two buckets per node keeps collisions between cells rare
+  uint32_t buckets = 1;
+  while (buckets < 2 * n) buckets <<= 1;
+  m_bucketMask = buckets - 1;
+
+  m_x.resize(n);
+  m_y.resize(n);
+  m_cx.resize(n);
+  m_cy.resize(n);
+  m_bucketOf.resize(n);
+  m_bucketStart.assign(buckets + 1, 0);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Vector position = m_mobility[i]->GetPosition();
+    m_x[i] = position.x;
+    m_y[i] = position.y;
+    m_cx[i] = (int64_t)floor(position.x / m_range);
+    m_cy[i] = (int64_t)floor(position.y / m_range);
+    m_bucketOf[i] = Bucket(m_cx[i], m_cy[i]);
+    m_bucketStart[m_bucketOf[i] + 1]++;
+  }
+
+  // counting sort of the nodes by bucket
+  for (uint32_t b = 0; b < buckets; b++) {
+    m_bucketStart[b + 1] += m_bucketStart[b];
+  }
+  m_order.resize(n);
+  for (uint32_t i = 0; i < n; i++) {
+    m_order[--m_bucketStart[m_bucketOf[i] + 1]] = i;
+  }
+  // the decrements above left every start one bucket early, shift them back
+  for (uint32_t i = 0; i < n; i++) {
+    m_bucketStart[m_bucketOf[i] + 1]++;
+  }
+
+  m_builtAt = Simulator::Now();
+  m_built = true;
+  m_graphBuilt = false;
+  m_cache.resize(n);
+  m_cachedHops.assign(n, 0);
+}
+
+void NeighborOracle::BuildGraph() {
+  m_graph.Clear();
+  for (uint32_t i = 0; i < m_nodes.size(); i++) {
+    Query(i, m_scratch);
+    m_graph.AddVertex(m_scratch.data(), m_scratch.size());
+  }
+  m_graphBuilt = true;
+}
+
+// indices of the nodes in direct range of node index
+void NeighborOracle::Query(uint32_t index, std::vector<uint32_t>& out) const {
+  out.clear();
+  double range2 = m_range * m_range;
+  double x = m_x[index];
+  double y = m_y[index];
+
+  uint32_t visited[9];
+  uint32_t numVisited = 0;
+  for (int64_t dx = -1; dx <= 1; dx++) {
+    for (int64_t dy = -1; dy <= 1; dy++) {
+      uint32_t b = Bucket(m_cx[index] + dx, m_cy[index] + dy);
+
+      // neighbouring cells can hash to the same bucket, scan each one once
+      if (std::find(visited, visited + numVisited, b) != visited + numVisited) continue;
+      visited[numVisited++] = b;
+
+      for (uint32_t k = m_bucketStart[b]; k < m_bucketStart[b + 1]; k++) {
+        uint32_t j = m_order[k];
+        double ddx = m_x[j] - x;
+        double ddy = m_y[j] - y;
+        if (j != index && ddx * ddx + ddy * ddy <= range2) {
+          out.push_back(j);
+        }
+      }
+    }
+  }
+}
+
+void NeighborOracle::GetNeighbors(uint32_t id, uint32_t maxHops, std::vector<uint32_t>& out) {
+  out.clear();
+  if (maxHops == 0) return;
+  Update();
+
+  auto it = m_index.find(id);
+  if (it == m_index.end()) {
+    NS_LOG_WARN("Node " << id << " is not tracked by the neighbor oracle");
+    return;
+  }
+  uint32_t index = it->second;
+
+  std::vector<uint32_t>& cached = m_cache[index];
+  if (m_cachedHops[index] != maxHops) {
+    if (maxHops <= 1) {
+      Query(index, cached);
+    } else {
+      if (!m_graphBuilt) BuildGraph();
+      m_graph.GetWithinHops(index, maxHops, cached);
+    }
+    for (uint32_t& v : cached) v = m_ids[v];
+    std::sort(cached.begin(), cached.end());
+    m_cachedHops[index] = maxHops;
+  }
+
+  out.assign(cached.begin(), cached.end());
+}
+
+void OracleNeighborSource::GetNeighbors(uint32_t maxHops, std::vector<uint32_t>& out) {
+  m_oracle->GetNeighbors(m_id, maxHops, out);
+}
+
+}  // namespace ecs
@@ -0,0 +1,118 @@
+/// \file neighbor-oracle.h
+/// \brief Shared ground truth neighbourhoods computed from node positions.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_NEIGHBOR_ORACLE_H
+#define __ECS_NEIGHBOR_ORACLE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include "neighbor-source.h"
+#include "neighborhood-graph.h"
+
+namespace ecs {
+
+using namespace ns3;
+
+/// \brief One instance per simulation that knows which nodes are within radio
+///     range of each other. Node positions are read from their MobilityModel
+///     and bucketed into a hashed uniform grid with cells one range wide, so
+///     everything in range of a node is in its own cell or one of the eight
+///     around it. The grid is rebuilt at most once per UpdateInterval, on the
+///     first query after the previous one went stale, and is shared by every
+///     node asking in between. Multi-hop neighbourhoods are found by a bounded
+///     BFS over the 1-hop links of every node, which are gathered into a
+///     NeighborhoodGraph the first time a tick needs them. Answers are cached
+///     per node until the next rebuild.
+class NeighborOracle : public Object {
+ public:
+  static TypeId GetTypeId();
+  NeighborOracle();
+
+  /// \brief Track the nodes, they need a MobilityModel and an IPv4 address on
+  ///     interface 1 by the time of the first query.
+  void Add(NodeContainer nodes);
+  void Add(Ptr<Node> node);
+
+  /// \brief Fill out with the ids (IPv4 addresses) of the nodes at most
+  ///     maxHops radio links away from the node with the given id, sorted
+  ///     with no duplicates.
+  void GetNeighbors(uint32_t id, uint32_t maxHops, std::vector<uint32_t>& out);
+
+ private:
+  void Update();
+  void Rebuild();
+  void ResolveIds();
+  uint32_t Bucket(int64_t cx, int64_t cy) const;
+  void Query(uint32_t index, std::vector<uint32_t>& out) const;
+  void BuildGraph();
+
+  double m_range;
+  Time m_updateInterval;
+  Time m_builtAt;
+  bool m_built;
+  bool m_resolved;
+
+  std::vector<Ptr<Node>> m_nodes;
+  std::vector<Ptr<MobilityModel>> m_mobility;
+  std::vector<uint32_t> m_ids;
+  std::unordered_map<uint32_t, uint32_t> m_index;
+
+  // positions and cells for the current tick, indexed like m_nodes
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<int64_t> m_cx;
+  std::vector<int64_t> m_cy;
+
+  // node indices grouped by hash bucket, bucket b is
+  // m_order[m_bucketStart[b] .. m_bucketStart[b + 1])
+  std::vector<uint32_t> m_bucketStart;
+  std::vector<uint32_t> m_order;
+  std::vector<uint32_t> m_bucketOf;
+  uint32_t m_bucketMask;
+
+  // 1-hop links between node indices, built on demand once per tick
+  NeighborhoodGraph m_graph;
+  bool m_graphBuilt;
+  std::vector<uint32_t> m_scratch;
+
+  // answers handed out this tick, m_cachedHops[i] is 0 when node i has none
+  std::vector<std::vector<uint32_t>> m_cache;
+  std::vector<uint32_t> m_cachedHops;
+};
+
+/// \brief Reads a node's neighbourhood from a shared NeighborOracle instead
+///     of its routing table, maxHops counts radio links.
+class OracleNeighborSource : public NeighborSource {
+ public:
+  OracleNeighborSource(Ptr<NeighborOracle> oracle, uint32_t id) : m_oracle(oracle), m_id(id) {}
+  void GetNeighbors(uint32_t maxHops, std::vector<uint32_t>& out) override;
+
+ private:
+  Ptr<NeighborOracle> m_oracle;
+  uint32_t m_id;
+};
+
+}  // namespace ecs
+
+#endif
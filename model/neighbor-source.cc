@@ -0,0 +1,329 @@
+/// \file neighbor-source.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "neighbor-source.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "ns3/aodv-packet.h"
+#include "ns3/aodv-rtable.h"
+#include "ns3/dsdv-packet.h"
+#include "ns3/dsdv-rtable.h"
+#include "ns3/fatal-error.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-list-routing.h"
+
+#include "table.h"
+
+namespace ecs {
+
+// ECS_ROUTE_TABLE_ACCESS is set by configure for the ns-3 releases whose
+// route tables were checked, ns-3.34. Elsewhere the adapters are not
+// registered and every protocol is read through TextNeighborSource.
+#ifdef ECS_ROUTE_TABLE_ACCESS
+
+// None of AODV, DSDV or OLSR expose their route tables, only a text dump of them.
+// Explicit template instantiations are exempt from access checking, which lets
+// us name the private members once here and read the entries without copying.
+// The member names and types are those of ns-3.34.
+template <typename Tag, typename Tag::type Member>
+struct PrivateMember {
+  friend typename Tag::type get(Tag) { return Member; }
+};
+
+struct AodvTable {
+  typedef aodv::RoutingTable aodv::RoutingProtocol::*type;
+  friend type get(AodvTable);
+};
+struct AodvEntries {
+  typedef std::map<Ipv4Address, aodv::RoutingTableEntry> aodv::RoutingTable::*type;
+  friend type get(AodvEntries);
+};
+struct DsdvTable {
+  typedef dsdv::RoutingTable dsdv::RoutingProtocol::*type;
+  friend type get(DsdvTable);
+};
+struct DsdvEntries {
+  typedef std::map<Ipv4Address, dsdv::RoutingTableEntry> dsdv::RoutingTable::*type;
+  friend type get(DsdvEntries);
+};
+struct OlsrTable {
+  typedef std::map<Ipv4Address, olsr::RoutingTableEntry> olsr::RoutingProtocol::*type;
+  friend type get(OlsrTable);
+};
+
+template struct PrivateMember<AodvTable, &aodv::RoutingProtocol::m_routingTable>;
+template struct PrivateMember<AodvEntries, &aodv::RoutingTable::m_ipv4AddressEntry>;
+template struct PrivateMember<DsdvTable, &dsdv::RoutingProtocol::m_routingTable>;
+template struct PrivateMember<DsdvEntries, &dsdv::RoutingTable::m_ipv4AddressEntry>;
+template struct PrivateMember<OlsrTable, &olsr::RoutingProtocol::m_table>;
+
+// loopback and broadcast routes are installed by both protocols but are not neighbours
+static bool isNeighborAddress(Ipv4Address address, Ipv4Mask mask) {
+  return !address.IsLocalhost() && !address.IsBroadcast() &&
+         !address.IsSubnetDirectedBroadcast(mask);
+}
+
+#endif
+
+// a route to destination hops away from us is new to the neighbourhood
+static bool addsNeighbor(Ipv4Address destination,
+                         uint32_t hops,
+                         uint32_t maxHops,
+                         const std::vector<uint32_t>& neighbors) {
+  return hops <= maxHops && !std::binary_search(neighbors.begin(), neighbors.end(), destination.Get());
+}
+
+const char* const RoutingAdapter<aodv::RoutingProtocol>::NAME = "aodv";
+const char* const RoutingAdapter<dsdv::RoutingProtocol>::NAME = "dsdv";
+const char* const RoutingAdapter<olsr::RoutingProtocol>::NAME = "olsr";
+
+typedef std::vector<std::pair<std::string, NeighborSource::Binder>> Registry;
+
+// built on first use so adapters can register from other static initializers
+static Registry& GetRegistry() {
+  static Registry registry = {
+#ifdef ECS_ROUTE_TABLE_ACCESS
+      {RoutingAdapter<aodv::RoutingProtocol>::NAME, &AodvNeighborSource::Bind},
+      {RoutingAdapter<dsdv::RoutingProtocol>::NAME, &DsdvNeighborSource::Bind},
+      {RoutingAdapter<olsr::RoutingProtocol>::NAME, &OlsrNeighborSource::Bind},
+#endif
+  };
+  return registry;
+}
+
+void NeighborSource::Register(std::string name, Binder binder) {
+  for (auto& entry : GetRegistry()) {
+    if (entry.first == name) {
+      entry.second = binder;
+      return;
+    }
+  }
+  GetRegistry().push_back(std::make_pair(name, binder));
+}
+
+static Ptr<NeighborSource> Bind(Ptr<Ipv4RoutingProtocol> protocol, const std::string& adapter) {
+  for (const auto& entry : GetRegistry()) {
+    if (!adapter.empty() && entry.first != adapter) continue;
+    Ptr<NeighborSource> source = entry.second(protocol);
+    if (source != 0) return source;
+  }
+  return Ptr<NeighborSource>();
+}
+
+Ptr<NeighborSource> NeighborSource::Create(Ptr<Ipv4> ipv4, std::string adapter) {
+  Ptr<Ipv4RoutingProtocol> protocol = ipv4->GetRoutingProtocol();
+
+  if (adapter != "text") {
+    Ptr<NeighborSource> source = Bind(protocol, adapter);
+
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(protocol);
+    if (list != 0) {
+      int16_t priority;
+      for (uint32_t i = 0; source == 0 && i < list->GetNRoutingProtocols(); i++) {
+        source = Bind(list->GetRoutingProtocol(i, priority), adapter);
+      }
+    }
+
+    if (source != 0) return source;
+    if (!adapter.empty()) {
+      NS_FATAL_ERROR("Routing adapter '" << adapter << "' does not match the node's routing protocol");
+    }
+  }
+
+  // interface 0 is the loopback, the mask of the first real one is used
+  Ipv4Mask mask = ipv4->GetNInterfaces() > 1 ? ipv4->GetAddress(1, 0).GetMask() : Ipv4Mask::GetOnes();
+  return ns3::Create<TextNeighborSource>(protocol, mask);
+}
+
+#ifdef ECS_ROUTE_TABLE_ACCESS
+void RoutingAdapter<aodv::RoutingProtocol>::GetNeighbors(
+    const aodv::RoutingProtocol& protocol,
+    uint32_t maxHops,
+    std::vector<uint32_t>& out) {
+  GetNeighbors(protocol.*get(AodvTable()), maxHops, out);
+}
+
+void RoutingAdapter<aodv::RoutingProtocol>::GetNeighbors(
+    const aodv::RoutingTable& table,
+    uint32_t maxHops,
+    std::vector<uint32_t>& out) {
+  out.clear();
+
+  const std::map<Ipv4Address, aodv::RoutingTableEntry>& entries = table.*get(AodvEntries());
+
+  // PrintRoutingTable purges a copy of the table first, which invalidates any
+  // route whose lifetime has run out, so only live VALID routes show as "UP"
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    const aodv::RoutingTableEntry& entry = it->second;
+    uint32_t hops = entry.GetHop();
+
+    if (entry.GetFlag() != aodv::VALID || entry.GetLifeTime().IsStrictlyNegative()) continue;
+    if (hops == 0 || hops > maxHops) continue;
+    if (!isNeighborAddress(it->first, entry.GetInterface().GetMask())) continue;
+
+    // the map is ordered by address so out stays sorted
+    out.push_back(it->first.Get());
+  }
+}
+
+void RoutingAdapter<dsdv::RoutingProtocol>::GetNeighbors(
+    const dsdv::RoutingProtocol& protocol,
+    uint32_t maxHops,
+    std::vector<uint32_t>& out) {
+  GetNeighbors(protocol.*get(DsdvTable()), maxHops, out);
+}
+
+void RoutingAdapter<dsdv::RoutingProtocol>::GetNeighbors(
+    const dsdv::RoutingTable& table,
+    uint32_t maxHops,
+    std::vector<uint32_t>& out) {
+  out.clear();
+
+  const std::map<Ipv4Address, dsdv::RoutingTableEntry>& entries = table.*get(DsdvEntries());
+
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    const dsdv::RoutingTableEntry& entry = it->second;
+    uint32_t hops = entry.GetHop();
+
+    if (entry.GetFlag() != dsdv::VALID) continue;
+    if (hops == 0 || hops > maxHops) continue;
+    if (!isNeighborAddress(it->first, entry.GetInterface().GetMask())) continue;
+
+    out.push_back(it->first.Get());
+  }
+}
+
+void RoutingAdapter<olsr::RoutingProtocol>::GetNeighbors(
+    const olsr::RoutingProtocol& protocol,
+    uint32_t maxHops,
+    std::vector<uint32_t>& out) {
+  out.clear();
+
+  // OLSR rebuilds its table from the topology on every change, so everything
+  // in it is live and it only holds host routes
+  const std::map<Ipv4Address, olsr::RoutingTableEntry>& entries = protocol.*get(OlsrTable());
+
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    uint32_t hops = it->second.distance;
+
+    if (hops == 0 || hops > maxHops) continue;
+    if (it->first.IsLocalhost() || it->first.IsBroadcast()) continue;
+
+    out.push_back(it->first.Get());
+  }
+}
+#endif
+
+bool RoutingAdapter<aodv::RoutingProtocol>::ChangesNeighbors(
+    Ipv4Address sender,
+    Ptr<Packet> message,
+    uint32_t maxHops,
+    const std::vector<uint32_t>& neighbors) {
+  // every message also refreshes the one hop route to its sender
+  if (addsNeighbor(sender, 1, maxHops, neighbors)) return true;
+
+  aodv::TypeHeader type;
+  message->RemoveHeader(type);
+  if (!type.IsValid()) return true;
+
+  // the receiver installs the route one hop further than the sender counts
+  switch (type.Get()) {
+    case aodv::AODVTYPE_RREQ: {
+      aodv::RreqHeader request;
+      message->RemoveHeader(request);
+      return addsNeighbor(request.GetOrigin(), request.GetHopCount() + 1, maxHops, neighbors);
+    }
+    case aodv::AODVTYPE_RREP: {
+      // hellos are replies for the sender itself with no hops
+      aodv::RrepHeader reply;
+      message->RemoveHeader(reply);
+      return addsNeighbor(reply.GetDst(), reply.GetHopCount() + 1, maxHops, neighbors);
+    }
+    case aodv::AODVTYPE_RERR: {
+      aodv::RerrHeader error;
+      message->RemoveHeader(error);
+      std::pair<Ipv4Address, uint32_t> unreachable;
+      while (error.RemoveUnDestination(unreachable)) {
+        if (std::binary_search(neighbors.begin(), neighbors.end(), unreachable.first.Get())) {
+          return true;
+        }
+      }
+      return false;
+    }
+    default:
+      return false;
+  }
+}
+
+bool RoutingAdapter<dsdv::RoutingProtocol>::ChangesNeighbors(
+    Ipv4Address sender,
+    Ptr<Packet> message,
+    uint32_t maxHops,
+    const std::vector<uint32_t>& neighbors) {
+  // an update is a run of entries, the sender advertises itself at 0 hops
+  dsdv::DsdvHeader entry;
+  while (message->GetSize() >= entry.GetSerializedSize()) {
+    message->RemoveHeader(entry);
+    if (entry.GetDstSeqno() % 2 == 1) {
+      // an odd sequence number marks a broken route
+      if (std::binary_search(neighbors.begin(), neighbors.end(), entry.GetDst().Get())) return true;
+    } else if (addsNeighbor(entry.GetDst(), entry.GetHopCount() + 1, maxHops, neighbors)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool RoutingAdapter<olsr::RoutingProtocol>::ChangesNeighbors(
+    Ipv4Address sender,
+    Ptr<Packet> message,
+    uint32_t maxHops,
+    const std::vector<uint32_t>& neighbors) {
+  return true;
+}
+
+StringSink::int_type StringSink::overflow(int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    m_text.push_back(traits_type::to_char_type(c));
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize StringSink::xsputn(const char* s, std::streamsize n) {
+  m_text.append(s, n);
+  return n;
+}
+
+TextNeighborSource::TextNeighborSource(Ptr<Ipv4RoutingProtocol> protocol, Ipv4Mask mask)
+    : m_protocol(protocol), m_mask(mask.Get()), m_layout(nullptr), m_stream(&m_sink) {
+  m_wrapper = ns3::Create<OutputStreamWrapper>(&m_stream);
+}
+
+void TextNeighborSource::GetNeighbors(uint32_t maxHops, std::vector<uint32_t>& out) {
+  m_sink.Clear();
+  m_protocol->PrintRoutingTable(m_wrapper);
+
+  if (m_layout == nullptr) m_layout = Table::DetectLayout(m_sink.View());
+  if (m_layout == nullptr) {
+    out.clear();
+    return;
+  }
+  Table::GetNeighbors(m_sink.View(), *m_layout, m_mask, maxHops, out);
+}
+
+}  // namespace ecs
@@ -0,0 +1,230 @@
+/// \file neighbor-source.h
+/// \brief Sources that report which destinations are within the neighbourhood
+///        of a node, read directly from the routing protocol where possible.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_NEIGHBOR_SOURCE_H
+#define __ECS_NEIGHBOR_SOURCE_H
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ns3/aodv-routing-protocol.h"
+#include "ns3/dsdv-routing-protocol.h"
+#include "ns3/olsr-routing-protocol.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/uinteger.h"
+
+namespace ecs {
+
+using namespace ns3;
+
+struct TableLayout;
+
+/// \brief Reports the destinations a node can currently reach within a hop limit.
+class NeighborSource : public SimpleRefCount<NeighborSource> {
+ public:
+  /// Returns a source reading the given protocol, or 0 if it is a different protocol.
+  typedef Ptr<NeighborSource> (*Binder)(Ptr<Ipv4RoutingProtocol> protocol);
+
+  virtual ~NeighborSource() {}
+
+  /// \brief Fill out with the ids (IPv4 addresses) of every destination that is
+  ///     at most maxHops away. out is cleared first and is left sorted in
+  ///     ascending order with no duplicates.
+  virtual void GetNeighbors(uint32_t maxHops, std::vector<uint32_t>& out) = 0;
+
+  /// \brief UDP port the routing protocol exchanges its control messages on,
+  ///     a message arriving there may have changed the routes. 0 if unknown.
+  virtual uint16_t GetControlPort() const { return 0; }
+
+  /// \brief Whether a control message received from sender can change which
+  ///     destinations are within maxHops, given the ones that currently are
+  ///     (sorted). message is the UDP payload and may be consumed. Sources
+  ///     that cannot tell say yes.
+  virtual bool ChangesNeighbors(Ipv4Address sender,
+                                Ptr<Packet> message,
+                                uint32_t maxHops,
+                                const std::vector<uint32_t>& neighbors) {
+    return true;
+  }
+
+  /// \brief Bind a source to the routing protocol of a node, looking inside an
+  ///     Ipv4ListRouting if need be. With an adapter name only that adapter is
+  ///     tried and not finding its protocol is fatal. Without one every
+  ///     registered adapter is tried in turn, falling back to parsing
+  ///     PrintRoutingTable. "text" always picks the fallback. The binding is
+  ///     done once, reading neighbours afterwards involves no protocol checks.
+  static Ptr<NeighborSource> Create(Ptr<Ipv4> ipv4, std::string adapter = "");
+
+  /// \brief Make an adapter available to Create under the given name.
+  static void Register(std::string name, Binder binder);
+  template <typename Protocol>
+  static void Register();
+};
+
+/// \brief How to read the neighbours out of one routing protocol. Each
+///     protocol gets a specialization providing
+///       static const char* const NAME;
+///       static const uint16_t CONTROL_PORT;
+///       static void GetNeighbors(const Protocol&, uint32_t maxHops, std::vector<uint32_t>&);
+///       static bool ChangesNeighbors(Ipv4Address sender, Ptr<Packet> message,
+///                                    uint32_t maxHops, const std::vector<uint32_t>&);
+///     and is registered with NeighborSource::Register<Protocol>().
+///     The AODV, DSDV and OLSR readers below use private members of ns-3.34
+///     and are only defined where configure found that release
+///     (ECS_ROUTE_TABLE_ACCESS).
+template <typename Protocol>
+struct RoutingAdapter;
+
+template <>
+struct RoutingAdapter<aodv::RoutingProtocol> {
+  static const char* const NAME;
+  static const uint16_t CONTROL_PORT = 654;
+  static void GetNeighbors(const aodv::RoutingProtocol& protocol,
+                           uint32_t maxHops,
+                           std::vector<uint32_t>& out);
+  /// \brief True for a route request or reply that installs a route to a
+  ///     destination not yet within maxHops, and for an error that breaks a
+  ///     route to one that is. Hellos from known neighbours are false.
+  static bool ChangesNeighbors(Ipv4Address sender,
+                               Ptr<Packet> message,
+                               uint32_t maxHops,
+                               const std::vector<uint32_t>& neighbors);
+  /// \brief The same read on a bare route table, gives the ids Table::GetNeighbors
+  ///     finds in the text the table prints.
+  static void GetNeighbors(const aodv::RoutingTable& table,
+                           uint32_t maxHops,
+                           std::vector<uint32_t>& out);
+};
+
+template <>
+struct RoutingAdapter<dsdv::RoutingProtocol> {
+  static const char* const NAME;
+  static const uint16_t CONTROL_PORT = 269;
+  static void GetNeighbors(const dsdv::RoutingProtocol& protocol,
+                           uint32_t maxHops,
+                           std::vector<uint32_t>& out);
+  /// \brief True if an advertised entry adds a destination within maxHops or
+  ///     withdraws (odd sequence number) one of the current neighbours.
+  static bool ChangesNeighbors(Ipv4Address sender,
+                               Ptr<Packet> message,
+                               uint32_t maxHops,
+                               const std::vector<uint32_t>& neighbors);
+  /// \brief The same read on a bare route table, gives the ids Table::GetNeighbors
+  ///     finds in the text the table prints.
+  static void GetNeighbors(const dsdv::RoutingTable& table,
+                           uint32_t maxHops,
+                           std::vector<uint32_t>& out);
+};
+
+template <>
+struct RoutingAdapter<olsr::RoutingProtocol> {
+  static const char* const NAME;
+  static const uint16_t CONTROL_PORT = 698;
+  static void GetNeighbors(const olsr::RoutingProtocol& protocol,
+                           uint32_t maxHops,
+                           std::vector<uint32_t>& out);
+  /// \brief Always true, OLSR recomputes its routes from link and topology
+  ///     sets that any of its messages may change.
+  static bool ChangesNeighbors(Ipv4Address sender,
+                               Ptr<Packet> message,
+                               uint32_t maxHops,
+                               const std::vector<uint32_t>& neighbors);
+};
+
+/// \brief Reads the routes of a Protocol in place through its RoutingAdapter.
+template <typename Protocol>
+class AdapterNeighborSource : public NeighborSource {
+ public:
+  typedef RoutingAdapter<Protocol> Adapter;
+
+  explicit AdapterNeighborSource(Ptr<Protocol> protocol) : m_protocol(protocol) {}
+
+  void GetNeighbors(uint32_t maxHops, std::vector<uint32_t>& out) override {
+    Adapter::GetNeighbors(*m_protocol, maxHops, out);
+  }
+  uint16_t GetControlPort() const override { return Adapter::CONTROL_PORT; }
+  bool ChangesNeighbors(Ipv4Address sender,
+                        Ptr<Packet> message,
+                        uint32_t maxHops,
+                        const std::vector<uint32_t>& neighbors) override {
+    return Adapter::ChangesNeighbors(sender, message, maxHops, neighbors);
+  }
+
+  static Ptr<NeighborSource> Bind(Ptr<Ipv4RoutingProtocol> protocol) {
+    Ptr<Protocol> match = DynamicCast<Protocol>(protocol);
+    if (match == 0) return Ptr<NeighborSource>();
+    return ns3::Create<AdapterNeighborSource<Protocol>>(match);
+  }
+
+ private:
+  Ptr<Protocol> m_protocol;
+};
+
+typedef AdapterNeighborSource<aodv::RoutingProtocol> AodvNeighborSource;
+typedef AdapterNeighborSource<dsdv::RoutingProtocol> DsdvNeighborSource;
+typedef AdapterNeighborSource<olsr::RoutingProtocol> OlsrNeighborSource;
+
+template <typename Protocol>
+void NeighborSource::Register() {
+  Register(RoutingAdapter<Protocol>::NAME, &AdapterNeighborSource<Protocol>::Bind);
+}
+
+/// \brief A streambuf that appends into a string which keeps its capacity
+///     between uses, so printing the routing table does not reallocate.
+class StringSink : public std::streambuf {
+ public:
+  void Clear() { m_text.clear(); }
+  std::string_view View() const { return m_text; }
+
+ protected:
+  int_type overflow(int_type c) override;
+  std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+ private:
+  std::string m_text;
+};
+
+/// \brief Fallback for protocols without an adapter, prints the routing table
+///     and parses the text with Table::GetNeighbors.
+class TextNeighborSource : public NeighborSource {
+ public:
+  /// \param mask Network mask of the node's interface, used to skip the
+  ///     subnet broadcast route.
+  TextNeighborSource(Ptr<Ipv4RoutingProtocol> protocol, Ipv4Mask mask);
+  void GetNeighbors(uint32_t maxHops, std::vector<uint32_t>& out) override;
+
+ private:
+  Ptr<Ipv4RoutingProtocol> m_protocol;
+  uint32_t m_mask;
+  // picked from the first dump, the protocol does not change afterwards
+  const TableLayout* m_layout;
+  StringSink m_sink;
+  std::ostream m_stream;
+  Ptr<OutputStreamWrapper> m_wrapper;
+};
+
+}  // namespace ecs
+
+#endif
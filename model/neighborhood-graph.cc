@@ -0,0 +1,69 @@
+/// \file neighborhood-graph.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "neighborhood-graph.h"
+
+#include <algorithm>
+
+namespace ecs {
+
+NeighborhoodGraph::NeighborhoodGraph() : m_epoch(0) { m_rowStart.push_back(0); }
+
+void NeighborhoodGraph::Clear() {
+  m_rowStart.resize(1);
+  m_adjacency.clear();
+}
+
+void NeighborhoodGraph::AddVertex(const uint32_t* neighbors, size_t count) {
+  m_adjacency.insert(m_adjacency.end(), neighbors, neighbors + count);
+  m_rowStart.push_back(m_adjacency.size());
+}
+
+void NeighborhoodGraph::GetWithinHops(
+    uint32_t source,
+    uint32_t maxHops,
+    std::vector<uint32_t>& out) {
+  out.clear();
+  if (source >= GetNumVertices() || maxHops == 0) return;
+
+  if (m_mark.size() < GetNumVertices()) m_mark.resize(GetNumVertices(), 0);
+  if (++m_epoch == 0) {
+    // the epoch wrapped, old marks could be mistaken for the new search
+    std::fill(m_mark.begin(), m_mark.end(), 0);
+    m_epoch = 1;
+  }
+  m_mark[source] = m_epoch;
+
+  // out doubles as the BFS queue, each level is the slice added by the last
+  size_t levelStart = 0;
+  size_t levelEnd = 0;
+  for (uint32_t hop = 0; hop < maxHops; hop++) {
+    size_t count = hop == 0 ? 1 : levelEnd - levelStart;
+    for (size_t k = 0; k < count; k++) {
+      uint32_t v = hop == 0 ? source : out[levelStart + k];
+      for (uint32_t e = m_rowStart[v]; e < m_rowStart[v + 1]; e++) {
+        uint32_t u = m_adjacency[e];
+        if (m_mark[u] == m_epoch) continue;
+        m_mark[u] = m_epoch;
+        out.push_back(u);
+      }
+    }
+    levelStart = levelEnd;
+    levelEnd = out.size();
+    if (levelStart == levelEnd) break;
+  }
+}
+
+}  // namespace ecs
@@ -0,0 +1,61 @@
+/// \file neighborhood-graph.h
+/// \brief Compact adjacency of the 1-hop neighbourhoods for h-hop queries.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_NEIGHBORHOOD_GRAPH_H
+#define __ECS_NEIGHBORHOOD_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ecs {
+
+/// \brief Undirected connectivity graph stored as compressed sparse rows,
+///     vertex v's neighbours are m_adjacency[m_rowStart[v] .. m_rowStart[v + 1]).
+///     The rows are appended in vertex order and the buffers are kept between
+///     rebuilds, so refreshing the graph every tick does not allocate. Only
+///     NeighborOracle builds one, a node reading its routing table has no view
+///     of the links between other nodes and takes hop counts from the routes.
+class NeighborhoodGraph {
+ public:
+  NeighborhoodGraph();
+
+  /// \brief Drop every vertex, ready for the rows to be added again.
+  void Clear();
+
+  /// \brief Append the next vertex along with the vertices it is linked to.
+  void AddVertex(const uint32_t* neighbors, size_t count);
+
+  uint32_t GetNumVertices() const { return m_rowStart.size() - 1; }
+
+  /// \brief Breadth first search from source that stops after maxHops levels.
+  ///     Fills out with every vertex reached, in BFS order and without source.
+  void GetWithinHops(uint32_t source, uint32_t maxHops, std::vector<uint32_t>& out);
+
+ private:
+  std::vector<uint32_t> m_rowStart;
+  std::vector<uint32_t> m_adjacency;
+
+  // a vertex has been visited by the current search when its mark equals the
+  // epoch, so nothing has to be cleared between searches
+  std::vector<uint32_t> m_mark;
+  uint32_t m_epoch;
+};
+
+}  // namespace ecs
+
+#endif
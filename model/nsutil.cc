@@ -45,6 +45,9 @@ RoutingType getRoutingType(std::string str) {
   if (lower == "aodv") {
     return RoutingType::AODV;
   }
+  if (lower == "olsr") {
+    return RoutingType::OLSR;
+  }
   return RoutingType::UNKNOWN;
 }
 
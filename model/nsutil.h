@@ -27,6 +27,7 @@
 #include "ns3/aodv-helper.h"
 //#include "ns3/core-module.h"
 #include "ns3/dsdv-helper.h"
+#include "ns3/olsr-helper.h"
 #include "ns3/ipv4-routing-helper.h"
 #include "ns3/random-walk-2d-mobility-model.h"
 
@@ -41,8 +42,8 @@ ns3::Time operator"" _sec(const long double seconds);
 ns3::Time operator"" _min(const long double minutes);
 
 /// \brief Routing type to use for the simulation.
-///   Supported values are DSDV and AODV.
-enum class RoutingType { DSDV, AODV, UNKNOWN };
+///   Supported values are DSDV, AODV and OLSR.
+enum class RoutingType { DSDV, AODV, OLSR, UNKNOWN };
 
 /// \brief Get the Routing Type enum from a string.
 ///
@@ -0,0 +1,58 @@
+/// \file replay-window.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "replay-window.h"
+
+namespace ecs {
+
+bool ReplayWindow::CheckDuplicate(uint64_t id, double now) {
+  uint32_t sequence = GetMessageSequence(id);
+  auto result = m_senders.emplace(GetMessageOrigin(id), Window{sequence, 1, now});
+  Window& window = result.first->second;
+  window.lastHeard = now;
+  if (result.second) return false;
+
+  // the difference wraps with the sequence number, so a sender that has sent
+  // more than 2^32 messages keeps working
+  uint32_t ahead = sequence - window.highest;
+  if (ahead != 0 && ahead < UINT32_MAX / 2) {
+    window.seen = ahead < WINDOW ? window.seen << ahead | 1 : 1;
+    window.highest = sequence;
+    return false;
+  }
+
+  uint32_t behind = window.highest - sequence;
+  if (behind >= WINDOW) return true;
+
+  uint64_t bit = (uint64_t)1 << behind;
+  bool duplicate = (window.seen & bit) != 0;
+  window.seen |= bit;
+  return duplicate;
+}
+
+size_t ReplayWindow::Expire(double before) {
+  size_t count = 0;
+  for (auto it = m_senders.begin(); it != m_senders.end();) {
+    if (it->second.lastHeard < before) {
+      it = m_senders.erase(it);
+      count++;
+    } else {
+      ++it;
+    }
+  }
+  return count;
+}
+
+}  // namespace ecs
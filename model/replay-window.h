@@ -0,0 +1,67 @@
+/// \file replay-window.h
+/// \brief Per-sender sliding window duplicate suppression for message ids.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_REPLAY_WINDOW_H
+#define __ECS_REPLAY_WINDOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+
+namespace ecs {
+
+/// \brief Message id made of the sending node and its own sequence number.
+inline uint64_t MakeMessageId(uint32_t origin, uint32_t sequence) {
+  return (uint64_t)origin << 32 | sequence;
+}
+inline uint32_t GetMessageOrigin(uint64_t id) { return (uint32_t)(id >> 32); }
+inline uint32_t GetMessageSequence(uint64_t id) { return (uint32_t)id; }
+
+/// \brief Remembers which message ids were already received, in the manner of
+///     the IPsec anti-replay window. Each sender gets the highest sequence
+///     number seen from it and a bitmap of the WINDOW numbers just below, so
+///     the memory is fixed per sender and a check is O(1). Anything older than
+///     the window is treated as a duplicate.
+class ReplayWindow {
+ public:
+  static constexpr uint32_t WINDOW = 64;
+
+  /// \brief true if id was already seen or is too old to tell, the id is
+  ///     recorded as seen either way.
+  bool CheckDuplicate(uint64_t id, double now);
+
+  /// \brief Forget the senders not heard from since before, a sender coming
+  ///     back starts a new window.
+  size_t Expire(double before);
+
+  size_t GetNumSenders() const { return m_senders.size(); }
+  void Clear() { m_senders.clear(); }
+
+ private:
+  struct Window {
+    uint32_t highest;
+    // bit i set when highest - i was received
+    uint64_t seen;
+    double lastHeard;
+  };
+
+  std::unordered_map<uint32_t, Window> m_senders;
+};
+
+}  // namespace ecs
+
+#endif
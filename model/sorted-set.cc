@@ -0,0 +1,123 @@
+/// \file sorted-set.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "sorted-set.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define ECS_SORTED_SET_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ecs {
+
+size_t IntersectionSizeScalar(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+  size_t count = 0;
+  size_t i = 0;
+  size_t j = 0;
+
+  // branchless merge, both cursors move when the heads are equal
+  while (i < na && j < nb) {
+    uint32_t x = a[i];
+    uint32_t y = b[j];
+    count += x == y;
+    i += x <= y;
+    j += y <= x;
+  }
+
+  return count;
+}
+
+#ifdef ECS_SORTED_SET_X86
+
+// Compare a block of a against every rotation of a block of b, every id is
+// unique within its array so each lane matches at most once. Whichever block
+// ends with the smaller id cannot match anything further along the other array
+// and is advanced, the leftovers are finished by the scalar merge.
+static size_t IntersectionSizeSse(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+  size_t count = 0;
+  size_t i = 0;
+  size_t j = 0;
+
+  while (i + 4 <= na && j + 4 <= nb) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+
+    __m128i match = _mm_cmpeq_epi32(va, vb);
+    match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+    match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+    match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+    count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(match)));
+
+    uint32_t lastA = a[i + 3];
+    uint32_t lastB = b[j + 3];
+    i += lastA <= lastB ? 4 : 0;
+    j += lastB <= lastA ? 4 : 0;
+  }
+
+  return count + IntersectionSizeScalar(a + i, na - i, b + j, nb - j);
+}
+
+__attribute__((target("avx2"))) static size_t IntersectionSizeAvx2(
+    const uint32_t* a,
+    size_t na,
+    const uint32_t* b,
+    size_t nb) {
+  size_t count = 0;
+  size_t i = 0;
+  size_t j = 0;
+
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+
+  while (i + 8 <= na && j + 8 <= nb) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+
+    __m256i match = _mm256_cmpeq_epi32(va, vb);
+    for (int r = 1; r < 8; r++) {
+      vb = _mm256_permutevar8x32_epi32(vb, rotate);
+      match = _mm256_or_si256(match, _mm256_cmpeq_epi32(va, vb));
+    }
+    count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(match)));
+
+    uint32_t lastA = a[i + 7];
+    uint32_t lastB = b[j + 7];
+    i += lastA <= lastB ? 8 : 0;
+    j += lastB <= lastA ? 8 : 0;
+  }
+
+  return count + IntersectionSizeSse(a + i, na - i, b + j, nb - j);
+}
+
+typedef size_t (*IntersectionFn)(const uint32_t*, size_t, const uint32_t*, size_t);
+
+static IntersectionFn SelectIntersection() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? IntersectionSizeAvx2 : IntersectionSizeSse;
+}
+
+size_t IntersectionSize(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+  static const IntersectionFn intersect = SelectIntersection();
+  return intersect(a, na, b, nb);
+}
+
+#else
+
+size_t IntersectionSize(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+  return IntersectionSizeScalar(a, na, b, nb);
+}
+
+#endif
+
+}  // namespace ecs
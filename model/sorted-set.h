@@ -0,0 +1,45 @@
+/// \file sorted-set.h
+/// \brief Set operations over sorted, duplicate free arrays of node ids.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_SORTED_SET_H
+#define __ECS_SORTED_SET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ecs {
+
+/// \brief Number of ids in both a and b. Both arrays must be sorted in
+///     ascending order without duplicates. Uses AVX2 or SSE2 when the CPU has
+///     it and a branchless merge otherwise, nothing is allocated.
+size_t IntersectionSize(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+/// \brief Scalar reference version of IntersectionSize.
+size_t IntersectionSizeScalar(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+inline size_t IntersectionSize(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+  return IntersectionSize(a.data(), a.size(), b.data(), b.size());
+}
+
+inline size_t UnionSize(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+  return a.size() + b.size() - IntersectionSize(a, b);
+}
+
+}  // namespace ecs
+
+#endif
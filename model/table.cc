@@ -15,211 +15,339 @@
 /// PERFORMANCE OF THIS SOFTWARE.
 ///
 #include "table.h"
-#include <math.h> /* isnan */
 
-#include <ctype.h>
+#include <algorithm>
 #include <iostream>
-#include <sstream>  // std::istringstream
 
-#include "ns3/ipv4-address.h"
+#include "neighbor-source.h"
+#include "sorted-set.h"
 
 namespace ecs {
 
-static std::vector<std::string> split(const std::string str, char seprater) {
-  std::vector<std::string> list;
-  std::string tmp = str;
+const TableLayout TableLayout::AODV = {0, 5, 3};
+const TableLayout TableLayout::DSDV = {0, 3, -1};
+const TableLayout TableLayout::OLSR = {0, 3, -1};
+
+static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// decode a dotted quad in place, false if the token is not exactly an IPv4 address
+static bool parseIpv4(std::string_view token, uint32_t& address) {
+  uint32_t result = 0;
+  uint32_t octet = 0;
+  int digits = 0;
+  int dots = 0;
+
+  for (char c : token) {
+    if (isDigit(c)) {
+      octet = octet * 10 + (c - '0');
+      if (++digits > 3 || octet > 255) return false;
+    } else if (c == '.' && digits > 0 && dots < 3) {
+      result = (result << 8) | octet;
+      octet = 0;
+      digits = 0;
+      dots++;
+    } else {
+      return false;
+    }
+  }
+  if (dots != 3 || digits == 0) return false;
 
-  size_t last = 0;
-  size_t pos = 0;
+  address = (result << 8) | octet;
+  return true;
+}
 
-  while ((pos = tmp.find(seprater, last)) != std::string::npos) {
-    list.push_back(tmp.substr(last, (pos - last)));
-    last = pos + 1;
-  }
+static bool parseUint(std::string_view token, uint32_t& value) {
+  if (token.empty() || token.size() > 9) return false;
 
-  return list;
+  uint32_t result = 0;
+  for (char c : token) {
+    if (!isDigit(c)) return false;
+    result = result * 10 + (c - '0');
+  }
+  value = result;
+  return true;
 }
 
-static std::string trim(const std::string str) {
-  std::string tmp = str;
-  tmp.erase(tmp.find_last_not_of(" \n\r\t") + 1);
-  tmp.erase(0, tmp.find_first_not_of(" \n\r\t"));
+static bool isLoopback(uint32_t address) { return address == 0x7f000001; }
 
-  return tmp;
+// limited broadcast, or the directed broadcast of a subnet with the given mask
+static bool isBroadcast(uint32_t address, uint32_t mask) {
+  return address == 0xffffffff || (mask != 0xffffffff && (address & ~mask) == ~mask);
 }
 
-static std::vector<std::string> trimStrings(const std::vector<std::string> strings) {
-  std::vector<std::string> list;
+const TableLayout* Table::DetectLayout(std::string_view table) {
+  // the first line of every dump names the protocol
+  std::string_view header = table.substr(0, table.find('\n'));
+  if (header.find("AODV") != std::string_view::npos) return &TableLayout::AODV;
+  if (header.find("DSDV") != std::string_view::npos) return &TableLayout::DSDV;
+  if (header.find("OLSR") != std::string_view::npos) return &TableLayout::OLSR;
+  return nullptr;
+}
 
-  for (auto it = strings.begin(); it != strings.end(); ++it) {
-    list.push_back(trim(*it));
+void Table::GetNeighbors(std::string_view table,
+                         uint32_t mask,
+                         uint32_t maxHops,
+                         std::vector<uint32_t>& out) {
+  const TableLayout* layout = DetectLayout(table);
+  if (layout == nullptr) {
+    out.clear();
+    return;
   }
-
-  return list;
+  GetNeighbors(table, *layout, mask, maxHops, out);
 }
 
-static std::vector<std::string> filterStrings(const std::vector<std::string> strings) {
-  std::vector<std::string> list;
+void Table::GetNeighbors(std::string_view table,
+                         const TableLayout& layout,
+                         uint32_t mask,
+                         uint32_t maxHops,
+                         std::vector<uint32_t>& out) {
+  out.clear();
 
-  for (auto it = strings.begin(); it != strings.end(); ++it) {
-    if ((*it).empty() || !isdigit((*it)[0])) {
-      continue;
+  size_t pos = 0;
+  while (pos < table.size()) {
+    size_t eol = table.find('\n', pos);
+    if (eol == std::string_view::npos) eol = table.size();
+    std::string_view line = table.substr(pos, eol - pos);
+    pos = eol + 1;
+
+    // split the line into whitespace separated columns, only remembering the
+    // ones the layout cares about
+    std::string_view destination, hops, flag;
+    int column = 0;
+    size_t i = 0;
+    while (i < line.size()) {
+      while (i < line.size() && isSpace(line[i])) i++;
+      if (i == line.size()) break;
+
+      size_t begin = i;
+      while (i < line.size() && !isSpace(line[i])) i++;
+      std::string_view token = line.substr(begin, i - begin);
+
+      // only route entries start with a digit, skip the headers
+      if (column == 0 && !isDigit(token[0])) break;
+
+      if (column == layout.destination) destination = token;
+      if (column == layout.hops) hops = token;
+      if (column == layout.flag) flag = token;
+      column++;
     }
-    list.push_back((*it));
-  }
 
-  return list;
-}
-
-static std::vector<std::string> tokenize(const std::string str) {
-  std::istringstream iss(str);
-  std::vector<std::string> tokens;
+    uint32_t address;
+    uint32_t hopCount;
+    if (!parseIpv4(destination, address) || !parseUint(hops, hopCount)) continue;
+    if (layout.flag >= 0 && flag != "UP") continue;
+    if (isLoopback(address) || isBroadcast(address, mask)) continue;
+    if (hopCount == 0 || hopCount > maxHops) continue;
 
-  for (std::string s; iss >> s;) {
-    tokens.push_back(s);
+    out.push_back(address);
   }
 
-  return tokens;
+  // the protocols print their tables ordered by destination already
+  if (!std::is_sorted(out.begin(), out.end())) std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
 }
 
-static bool isLoopback(const std::string address) { return address == "127.0.0.1"; }
+Table::Table() : Table(0, 0) {}
 
-// note this will only work in network with a mask of 255.255.0.0!!!!!!
-static bool isBroadcast(const std::string address) {
-  return address.find(".255.255") != std::string::npos;
+Table::Table(uint16_t num, uint32_t filter) {
+  numTables = num;
+  maxHops = filter;
+  deltaHead = 0;
+  historySize = 0;
+  intersectSize = 0;
 }
 
-static std::vector<std::string> getDsdvDestinations(
-    const std::vector<std::string> enteries,
-    uint32_t maxHops) {
-  std::vector<std::string> list;
-
-  for (auto entry : enteries) {
-    std::vector<std::string> parts = tokenize(entry);
-
-    uint32_t hops = (uint32_t)std::stoi(parts[3], nullptr, 10);
-
-    if (isLoopback(parts[0]) || isBroadcast(parts[0])) continue;
-    if (hops <= 0 || hops > maxHops) continue;
-
-    list.push_back(parts[0]);
+void Table::Diff(const std::vector<uint32_t>& before,
+                 const std::vector<uint32_t>& after,
+                 TableDelta& delta) {
+  delta.added.clear();
+  delta.removed.clear();
+
+  size_t i = 0;
+  size_t j = 0;
+  while (i < before.size() && j < after.size()) {
+    if (before[i] < after[j]) {
+      delta.removed.push_back(before[i++]);
+    } else if (after[j] < before[i]) {
+      delta.added.push_back(after[j++]);
+    } else {
+      i++;
+      j++;
+    }
   }
-
-  return list;
+  delta.removed.insert(delta.removed.end(), before.begin() + i, before.end());
+  delta.added.insert(delta.added.end(), after.begin() + j, after.end());
 }
 
-static std::vector<std::string> getAodvDestinations(
-    const std::vector<std::string> enteries,
-    uint32_t maxHops) {
-  std::vector<std::string> list;
-
-  for (auto entry : enteries) {
-    std::vector<std::string> parts = tokenize(entry);
+void Table::Apply(const std::vector<uint32_t>& before,
+                  const TableDelta& delta,
+                  std::vector<uint32_t>& after) {
+  // after = (before - removed) + added, all three sorted
+  after.clear();
+  size_t r = 0;
+  size_t a = 0;
+  for (uint32_t id : before) {
+    while (r < delta.removed.size() && delta.removed[r] < id) r++;
+    if (r < delta.removed.size() && delta.removed[r] == id) continue;
+    while (a < delta.added.size() && delta.added[a] < id) after.push_back(delta.added[a++]);
+    after.push_back(id);
+  }
+  after.insert(after.end(), delta.added.begin() + a, delta.added.end());
+}
 
-    uint32_t hops = (uint32_t)std::stoi(parts[5], nullptr, 10);
+static void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
 
-    if (parts[3] != "UP") continue;
-    if (isLoopback(parts[0]) || isBroadcast(parts[0])) continue;
-    if (hops <= 0 || hops > maxHops) continue;
+static uint32_t getVarint(const uint8_t*& in) {
+  uint32_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t byte = *in++;
+    value |= (uint32_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return value;
+  }
+}
 
-    list.push_back(parts[0]);
+// sorted ids are stored as the first id followed by the gap to each next one,
+// neighbours share a subnet so the gaps mostly fit in one or two bytes
+static void putIds(std::vector<uint8_t>& out, const std::vector<uint32_t>& ids) {
+  putVarint(out, ids.size());
+  uint32_t last = 0;
+  for (uint32_t id : ids) {
+    putVarint(out, id - last);
+    last = id;
   }
+}
 
-  return list;
+static void getIds(const uint8_t*& in, std::vector<uint32_t>& ids) {
+  ids.resize(getVarint(in));
+  uint32_t last = 0;
+  for (uint32_t& id : ids) {
+    last += getVarint(in);
+    id = last;
+  }
 }
 
-static uint32_t convertIpv4(const std::string address) {
-  return ns3::Ipv4Address(address.c_str()).Get();
+static const uint8_t* getDelta(const uint8_t* in, TableDelta& delta) {
+  getIds(in, delta.added);
+  getIds(in, delta.removed);
+  return in;
 }
 
-static std::set<uint32_t> createSet(const std::vector<std::string> destinations) {
-  std::set<uint32_t> table;
+static bool contains(const std::vector<uint32_t>& ids, uint32_t id) {
+  return std::binary_search(ids.begin(), ids.end(), id);
+}
 
-  for (auto entry : destinations) {
-    table.insert(convertIpv4(entry));
-  }
+// Roll the oldest snapshot forward by one step, the ids that enter or leave it
+// only change the intersection if they are also in the current snapshot.
+void Table::advanceOldest(const TableDelta& delta) {
+  for (uint32_t id : delta.added) intersectSize += contains(current, id);
+  for (uint32_t id : delta.removed) intersectSize -= contains(current, id);
 
-  return table;
+  Apply(oldest, delta, scratch);
+  oldest.swap(scratch);
 }
 
-static std::set<uint32_t> setUnion(const std::set<uint32_t> a, const std::set<uint32_t> b) {
-  std::set<uint32_t> res;
+// Drop the delta right after the oldest snapshot, folding it into the snapshot
+void Table::popDelta() {
+  const uint8_t* next = getDelta(deltaBytes.data() + deltaHead, decoded);
+  deltaHead = next - deltaBytes.data();
+  historySize--;
+  times.pop_front();
+  advanceOldest(decoded);
+
+  // once the dead prefix is most of the buffer shift the live part down, so
+  // the buffer stays contiguous at a bounded size
+  if (deltaHead * 2 >= deltaBytes.size()) {
+    deltaBytes.erase(deltaBytes.begin(), deltaBytes.begin() + deltaHead);
+    deltaHead = 0;
+  }
+}
 
-  for (auto item : a) {
-    res.insert(item);
+// scratch holds the neighbours from the newest scan
+void Table::applyScan(double now) {
+  // the empty table before the first scan counts as taken at the same time
+  if (times.empty()) times.push_back(now);
+  if (numTables > 1) times.push_back(now);
+  else times.back() = now;
+
+  Diff(current, scratch, lastDelta);
+  current.swap(scratch);
+
+  for (uint32_t id : lastDelta.added) intersectSize += contains(oldest, id);
+  for (uint32_t id : lastDelta.removed) intersectSize -= contains(oldest, id);
+
+  if (numTables > 1) {
+    putIds(deltaBytes, lastDelta.added);
+    putIds(deltaBytes, lastDelta.removed);
+    historySize++;
+    // the window is full, the delta after the oldest snapshot falls out of it
+    if (historySize >= numTables) popDelta();
+  } else if (numTables == 1) {
+    advanceOldest(lastDelta);
   }
 
-  for (auto item : b) {
-    res.insert(item);
+  if (!lastDelta.empty() && !changeCallback.IsNull()) {
+    changeCallback(lastDelta.added, lastDelta.removed);
   }
-  return res;
 }
 
-static std::set<uint32_t> setIntersection(const std::set<uint32_t> a, const std::set<uint32_t> b) {
-  std::set<uint32_t> res;
+static double changeDegree(size_t a, size_t b, size_t intersect) {
+  size_t unionSize = a + b - intersect;
+  if (unionSize == 0) return 0;
 
-  for (auto item : a) {
-    if (b.find(item) != b.end()) res.insert(item);
-  }
-
-  return res;
+  return (unionSize - intersect) / (double)unionSize;
 }
 
-std::set<uint32_t> Table::GetNeighbors(const std::string table, uint32_t maxHops) {
-  std::vector<std::string> parts = split(table, '\n');
-  std::vector<std::string> trimmed = trimStrings(parts);
-  std::vector<std::string> filtered = filterStrings(trimmed);
+double Table::ComputeChangeDegree() const {
+  // 0 if there are no tables to handle edge case
+  if (numTables == 0) return 0;
 
-  std::vector<std::string> destinations;
+  return changeDegree(current.size(), oldest.size(), intersectSize);
+}
 
-  if (table.find("AODV") != std::string::npos) {
-    destinations = getAodvDestinations(filtered, maxHops);
-  } else if (table.find("DSDV") != std::string::npos) {
-    destinations = getDsdvDestinations(filtered, maxHops);
+double Table::ComputeChangeDegree(uint16_t steps) const {
+  if (numTables == 0 || steps == 0) return 0;
+  if (steps >= historySize) return ComputeChangeDegree();
+
+  // replay the deltas from the oldest snapshot up to the one steps back
+  const uint8_t* in = deltaBytes.data() + deltaHead;
+  windowA = oldest;
+  for (uint16_t i = 0; i < historySize - steps; i++) {
+    in = getDelta(in, decoded);
+    Apply(windowA, decoded, windowB);
+    windowA.swap(windowB);
   }
 
-  return createSet(destinations);
+  return changeDegree(current.size(), windowA.size(), IntersectionSize(current, windowA));
 }
 
-Table::Table() {
-  numTables = 0;
-  currentTable = 0;
-  lastTable = 0;
-  numTables = 0;
-  maxHops = 0;
-  tables.resize(0);
-}
+double Table::ComputeChangeDegreeOver(double window) const {
+  if (historySize == 0) return 0;
 
-Table::Table(uint16_t num, uint32_t filter) {
-  numTables = num;
-  currentTable = 0;
-  lastTable = 0;
-  maxHops = filter;
-  tables.resize(numTables);
-}
+  // times holds historySize + 1 entries, the snapshot steps back is at historySize - steps
+  double now = times.back();
+  uint16_t steps = 1;
+  while (steps < historySize && now - times[historySize - steps] < window) steps++;
 
-void Table::nextTable() {
-  currentTable = (currentTable + 1) % numTables;
-  lastTable = (currentTable + 1) % numTables;
+  double age = now - times[historySize - steps];
+  double degree = ComputeChangeDegree(steps);
+  return age > window ? degree * window / age : degree;
 }
 
-double Table::ComputeChangeDegree() const {
-  // 0 if there are no tables to handle edge case
-  if (numTables == 0 || currentTable >= numTables || lastTable >= numTables) return 0;
-
-  uint16_t unionSize = setUnion(tables[currentTable], tables[lastTable]).size();
-  uint16_t intersectSize = setIntersection(tables[currentTable], tables[lastTable]).size();
-
-  double res = (unionSize - intersectSize) / (double)unionSize;
-  return isnan(res) ? 0 : res;
+void Table::UpdateTable(std::string_view table, uint32_t mask, double now) {
+  Table::GetNeighbors(table, mask, maxHops, scratch);
+  applyScan(now);
 }
 
-void Table::UpdateTable(const std::string table) {
-  nextTable();
-  tables[currentTable] = Table::GetNeighbors(table, maxHops);
-
-  // std::cout << "========================================\n" << table <<
-  // "===========================================\n";
+void Table::UpdateTable(NeighborSource& source, double now) {
+  source.GetNeighbors(maxHops, scratch);
+  applyScan(now);
 }
 
 }  // namespace ecs
@@ -19,31 +19,134 @@
 #ifndef __ECS_TABLE_H
 #define __ECS_TABLE_H
 
+#include "ns3/callback.h"
 #include "ns3/uinteger.h"
 
-#include <set>  // std::set
-#include <string>
+#include <deque>
+#include <string_view>
 #include <vector>  // std::vector
 
 namespace ecs {
 
+class NeighborSource;
+
+/// \brief Columns of the text a protocol's PrintRoutingTable writes.
+struct TableLayout {
+  int destination;
+  int hops;
+  int flag;  // -1 if the protocol does not print a route flag
+
+  static const TableLayout AODV;
+  static const TableLayout DSDV;
+  static const TableLayout OLSR;
+};
+
+/// \brief The neighbours that appeared and disappeared between two scans.
+struct TableDelta {
+  std::vector<uint32_t> added;
+  std::vector<uint32_t> removed;
+
+  bool empty() const { return added.empty() && removed.empty(); }
+};
+
 class Table {
+ public:
+  /// Called with the ids that were added and removed whenever a scan changes the neighbourhood.
+  typedef ns3::Callback<void, const std::vector<uint32_t>&, const std::vector<uint32_t>&>
+      ChangeCallback;
+
  private:
   uint16_t numTables;
-  uint16_t currentTable;
-  uint16_t lastTable;
   uint32_t maxHops;
-  std::vector<std::set<uint32_t> > tables;
 
-  void nextTable();
+  // Only the newest and the oldest snapshot in the window are kept as id
+  // lists, both sorted and duplicate free. The deltas that lead from the
+  // oldest to the newest are packed into one byte buffer, each as varint
+  // counts followed by the gaps between consecutive ids.
+  std::vector<uint32_t> current;
+  std::vector<uint32_t> oldest;
+  std::vector<uint8_t> deltaBytes;
+  size_t deltaHead;
+  uint16_t historySize;
+  // when each snapshot in the window was taken, oldest first
+  std::deque<double> times;
+  TableDelta lastDelta;
+  std::vector<uint32_t> scratch;
+
+  // only used while decoding, no state carries over between calls
+  mutable TableDelta decoded;
+  mutable std::vector<uint32_t> windowA;
+  mutable std::vector<uint32_t> windowB;
+
+  // |current n oldest|, kept up to date from the deltas
+  size_t intersectSize;
+
+  ChangeCallback changeCallback;
+
+  void applyScan(double now);
+  void advanceOldest(const TableDelta& delta);
+  void popDelta();
 
  public:
   Table();
   Table(uint16_t num, uint32_t hops);
+
+  /// \brief Fraction of the neighbours across the window that are not in both
+  ///     the oldest and the newest snapshot, O(1).
   double ComputeChangeDegree() const;
-  void UpdateTable(const std::string table);
+  /// \brief Change degree between the newest snapshot and the one steps
+  ///     updates before it, limited to the history that is kept. Replays the
+  ///     stored deltas, so it costs time in the size of the window.
+  double ComputeChangeDegree(uint16_t steps) const;
+  /// \brief Change degree over about window seconds, between the newest
+  ///     snapshot and the newest one at least window old (or the oldest kept).
+  ///     When that one is older than window the degree is scaled by
+  ///     window / age, so it stays a per window figure however far apart the
+  ///     updates are.
+  double ComputeChangeDegreeOver(double window) const;
+  /// \brief Number of updates the oldest snapshot in the window lags behind.
+  uint16_t GetHistorySize() const { return historySize; }
+  /// \brief Bytes used by the encoded deltas.
+  size_t GetHistoryBytes() const { return deltaBytes.size() - deltaHead; }
+  /// \brief Take a new snapshot, now is the time of the scan in seconds.
+  void UpdateTable(std::string_view table, uint32_t mask, double now);
+  void UpdateTable(NeighborSource& source, double now);
+
+  /// \brief The neighbours added and removed by the most recent update.
+  const TableDelta& GetLastDelta() const { return lastDelta; }
+  /// \brief The neighbours seen by the most recent update.
+  const std::vector<uint32_t>& GetNeighbors() const { return current; }
+  void SetChangeCallback(ChangeCallback callback) { changeCallback = callback; }
+
+  /// \brief Parse a PrintRoutingTable dump in a single pass, writing the ids of
+  ///     the destinations within maxHops into out (sorted, no duplicates).
+  ///     Routes to the directed broadcast address of mask are skipped.
+  static void GetNeighbors(std::string_view table,
+                           const TableLayout& layout,
+                           uint32_t mask,
+                           uint32_t maxHops,
+                           std::vector<uint32_t>& out);
+  /// \brief As above for a dump of unknown origin, the layout is picked from
+  ///     the protocol named in its first line. mask is the network mask of the
+  ///     node's interface address.
+  static void GetNeighbors(std::string_view table,
+                           uint32_t mask,
+                           uint32_t maxHops,
+                           std::vector<uint32_t>& out);
+  /// \brief The layout for the protocol named in the first line of a dump, or
+  ///     nullptr if it is not one we know.
+  static const TableLayout* DetectLayout(std::string_view table);
+
+  /// \brief Merge two sorted id lists into what was added to and removed from
+  ///     before to get after.
+  static void Diff(const std::vector<uint32_t>& before,
+                   const std::vector<uint32_t>& after,
+                   TableDelta& delta);
 
-  static std::set<uint32_t> GetNeighbors(const std::string table, uint32_t maxHops);
+  /// \brief Inverse of Diff, writes before with delta applied into after.
+  static void Apply(const std::vector<uint32_t>& before,
+                    const TableDelta& delta,
+                    std::vector<uint32_t>& after);
 };
 
 }  // namespace ecs
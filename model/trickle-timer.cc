@@ -0,0 +1,47 @@
+/// \file trickle-timer.cc
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#include "trickle-timer.h"
+
+#include <algorithm>
+
+namespace ecs {
+
+TrickleTimer::TrickleTimer() : TrickleTimer(Seconds(1), Seconds(1), 0) {}
+
+TrickleTimer::TrickleTimer(Time imin, Time imax, uint32_t k)
+    : m_imin(imin), m_imax(std::max(imin, imax)), m_k(k) {
+  m_interval = m_imin;
+  m_counter = 0;
+}
+
+Time TrickleTimer::StartInterval(double u) {
+  m_counter = 0;
+  // the first half of the interval is listen only, so a node that has just
+  // reset does not answer at the same moment as every neighbour that did too
+  return Seconds(m_interval.GetSeconds() / 2 * (1 + u));
+}
+
+void TrickleTimer::EndInterval() { m_interval = GetNextInterval(); }
+
+bool TrickleTimer::Reset() {
+  if (m_interval <= m_imin) return false;
+  m_interval = m_imin;
+  return true;
+}
+
+Time TrickleTimer::GetNextInterval() const { return std::min(m_interval + m_interval, m_imax); }
+
+}  // namespace ecs
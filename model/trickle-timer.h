@@ -0,0 +1,70 @@
+/// \file trickle-timer.h
+/// \brief Trickle timer (RFC 6206) pacing a periodic broadcast.
+///
+/// Copyright (c) 2022 by Patrick Houlding <phouldin@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+///
+#ifndef __ECS_TRICKLE_TIMER_H
+#define __ECS_TRICKLE_TIMER_H
+
+#include <stdint.h>
+
+#include "ns3/nstime.h"
+
+namespace ecs {
+
+using namespace ns3;
+
+/// \brief The message is due once per interval I, at a random point t in
+///     [I/2, I), and is only sent if fewer than k consistent copies have been
+///     heard since the interval began. An interval that ends quietly doubles
+///     I up to the maximum, an inconsistency drops it back to the minimum.
+///     A k of 0 never suppresses, which leaves only the interval doubling.
+class TrickleTimer {
+ public:
+  TrickleTimer();
+  TrickleTimer(Time imin, Time imax, uint32_t k);
+
+  /// \brief Begin an interval of the current length and clear the counter.
+  ///     u is uniform in [0, 1), returns t, when the send is due.
+  Time StartInterval(double u);
+
+  /// \brief The current interval is over, the next one is twice as long.
+  void EndInterval();
+
+  /// \brief Back to the minimum interval on an inconsistency. False when it
+  ///     was there already, in which case the running interval is kept.
+  bool Reset();
+
+  /// \brief A consistent transmission was heard in this interval.
+  void Heard() { m_counter++; }
+
+  bool ShouldSend() const { return m_k == 0 || m_counter < m_k; }
+
+  Time GetInterval() const { return m_interval; }
+  /// \brief Length of the interval after this one if it ends quietly.
+  Time GetNextInterval() const;
+  uint32_t GetCounter() const { return m_counter; }
+
+ private:
+  Time m_imin;
+  Time m_imax;
+  uint32_t m_k;
+
+  Time m_interval;
+  uint32_t m_counter;
+};
+
+}  // namespace ecs
+
+#endif
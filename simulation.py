@@ -31,7 +31,8 @@ param_combination = {
     'hops': [1],
     'areaWidth': [2000],
     'areaLength': [2000],
-    'travellerVelocity': [2.0, 5.0, 10.0, 15.0, 18.0]
+    'travellerVelocity': [2.0, 5.0, 10.0, 15.0, 18.0],
+    'expiry': ['sweep', 'lazy']
 }
 
 def runSimulation():
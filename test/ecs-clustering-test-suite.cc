@@ -1,7 +1,36 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
 // Include a header file from your module to test.
+#include "ns3/adaptive-interval.h"
+#include "ns3/aodv-packet.h"
+#include "ns3/aodv-rtable.h"
+#include "ns3/cluster-membership.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/dsdv-packet.h"
+#include "ns3/dsdv-rtable.h"
+#include "ns3/duplicate-filter.h"
 #include "ns3/ecs-clustering.h"
+#include "ns3/ecs-header.h"
+#include "ns3/information-table.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/neighbor-oracle.h"
+#include "ns3/neighbor-source.h"
+#include "ns3/neighborhood-graph.h"
+#include "ns3/replay-window.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/sorted-set.h"
+#include "ns3/table.h"
+#include "ns3/trickle-timer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -46,6 +75,1682 @@ EcsClusteringTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Checks that the routing table dump parser picks out the same neighbours the
+// protocols report, for both the AODV and the DSDV column layouts.
+class TableParserTestCase : public TestCase
+{
+public:
+  TableParserTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TableParserTestCase::TableParserTestCase ()
+  : TestCase ("Routing table dumps are parsed into neighbour ids")
+{
+}
+
+void
+TableParserTestCase::DoRun (void)
+{
+  std::string aodv =
+    "Node: 0; Time: +10s, Local time: +10s, AODV Routing table\n"
+    "\nAODV Routing table\n"
+    "Destination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n"
+    "10.1.0.2\t10.1.0.2\t10.1.0.1\tUP\t+2.90s\t\t1\n"
+    "10.1.0.3\t10.1.0.2\t10.1.0.1\tUP\t+2.90s\t\t2\n"
+    "10.1.0.4\t10.1.0.4\t10.1.0.1\tDOWN\t+0.10s\t\t1\n"
+    "10.1.1.5\t10.1.1.5\t10.1.0.1\tUP\t+1.00s\t\t1\n"
+    "10.1.255.255\t10.1.255.255\t10.1.0.1\tUP\t+9223372036.85s\t\t1\n"
+    "127.0.0.1\t127.0.0.1\t127.0.0.1\tUP\t+9223372036.85s\t\t1\n"
+    "\n";
+
+  uint32_t mask = Ipv4Mask ("255.255.0.0").Get ();
+  std::vector<uint32_t> neighbors;
+  ecs::Table::GetNeighbors (aodv, mask, 1, neighbors);
+  NS_TEST_ASSERT_MSG_EQ (neighbors.size (), 2, "only live one hop routes are neighbours");
+  NS_TEST_ASSERT_MSG_EQ (neighbors[0], Ipv4Address ("10.1.0.2").Get (), "wrong first neighbour");
+  NS_TEST_ASSERT_MSG_EQ (neighbors[1], Ipv4Address ("10.1.1.5").Get (), "wrong second neighbour");
+
+  ecs::Table::GetNeighbors (aodv, mask, 2, neighbors);
+  NS_TEST_ASSERT_MSG_EQ (neighbors.size (), 3, "two hop route should be included");
+
+  std::string dsdv =
+    "Node: 0; Time: +10s, Local time: +10s, DSDV Routing table\n"
+    "\nDSDV Routing table\n"
+    "Destination\t\tGateway\t\tInterface\t\tHopCount\t\tSeqNum\t\tLifeTime\t\tSettlingTime\n"
+    "10.1.0.2\t\t10.1.0.2\t\t10.1.0.1\t\t1\t\t4\t\t+3s\t\t+0s\n"
+    "10.1.0.3\t\t10.1.0.2\t\t10.1.0.1\t\t2\t\t8\t\t+3s\t\t+0s\n"
+    "127.0.0.1\t\t127.0.0.1\t\t127.0.0.1\t\t0\t\t0\t\t+10s\t\t+0s\n";
+
+  ecs::Table::GetNeighbors (dsdv, mask, 1, neighbors);
+  NS_TEST_ASSERT_MSG_EQ (neighbors.size (), 1, "only the one hop DSDV route is a neighbour");
+  NS_TEST_ASSERT_MSG_EQ (neighbors[0], Ipv4Address ("10.1.0.2").Get (), "wrong DSDV neighbour");
+
+  std::string olsr =
+    "Node: 0, Time: +10s, Local time: +10s, OLSR Routing table\n"
+    "Destination\t\tNextHop\t\tInterface\tDistance\n"
+    "10.1.0.2\t\t10.1.0.2\t\t1\t\t1\n"
+    "10.1.0.3\t\t10.1.0.2\t\t1\t\t2\n"
+    "10.1.0.255\t\t10.1.0.255\t\t1\t\t1\n";
+
+  NS_TEST_ASSERT_MSG_EQ ((ecs::Table::DetectLayout (olsr) == &ecs::TableLayout::OLSR), true,
+                         "OLSR dump not recognised");
+  ecs::Table::GetNeighbors (olsr, ecs::TableLayout::OLSR, Ipv4Mask ("255.255.255.0").Get (), 2,
+                            neighbors);
+  NS_TEST_ASSERT_MSG_EQ (neighbors.size (), 2, "the /24 broadcast route is not a neighbour");
+  NS_TEST_ASSERT_MSG_EQ (neighbors[1], Ipv4Address ("10.1.0.3").Get (), "wrong OLSR neighbour");
+
+  // with a /16 mask 10.1.0.255 is an ordinary host
+  ecs::Table::GetNeighbors (olsr, ecs::TableLayout::OLSR, Ipv4Mask ("255.255.0.0").Get (), 1,
+                            neighbors);
+  NS_TEST_ASSERT_MSG_EQ (neighbors.size (), 2, "10.1.0.255 is a host in a /16");
+}
+
+#ifdef ECS_ROUTE_TABLE_ACCESS
+// Fills AODV and DSDV route tables and checks that reading the entries in
+// place gives the neighbours parsing the text the tables print did.
+class RouteReaderTestCase : public TestCase
+{
+public:
+  RouteReaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RouteReaderTestCase::RouteReaderTestCase ()
+  : TestCase ("Route table readers match the text parser")
+{
+}
+
+void
+RouteReaderTestCase::DoRun (void)
+{
+  Ipv4InterfaceAddress iface (Ipv4Address ("10.1.0.1"), Ipv4Mask ("255.255.0.0"));
+  uint32_t mask = iface.GetMask ().Get ();
+  std::vector<uint32_t> expected;
+  std::vector<uint32_t> actual;
+
+  struct Route
+  {
+    const char *destination;
+    uint32_t hops;
+    int flag;
+    double lifetime;
+  };
+  // an expired route is purged to DOWN before the table is printed
+  const Route aodvRoutes[] = {
+    {"10.1.0.2", 1, aodv::VALID, 3},
+    {"10.1.0.3", 2, aodv::VALID, 3},
+    {"10.1.0.4", 1, aodv::INVALID, 3},
+    {"10.1.0.5", 1, aodv::IN_SEARCH, 3},
+    {"10.1.0.6", 1, aodv::VALID, -1},
+    {"10.1.1.7", 3, aodv::VALID, 3},
+    {"10.1.255.255", 1, aodv::VALID, 1e6},
+    {"127.0.0.1", 1, aodv::VALID, 1e6},
+  };
+
+  aodv::RoutingTable aodvTable (Seconds (5));
+  for (const Route &route : aodvRoutes)
+    {
+      Ipv4Address destination (route.destination);
+      aodv::RoutingTableEntry entry (0, destination, true, 1, iface, route.hops, destination,
+                                     Seconds (route.lifetime));
+      entry.SetFlag (static_cast<aodv::RouteFlags> (route.flag));
+      aodvTable.AddRoute (entry);
+    }
+  std::ostringstream aodvText;
+  aodvTable.Print (Create<OutputStreamWrapper> (&aodvText));
+
+  for (uint32_t maxHops = 1; maxHops <= 3; maxHops++)
+    {
+      ecs::Table::GetNeighbors (aodvText.str (), ecs::TableLayout::AODV, mask, maxHops, expected);
+      ecs::RoutingAdapter<aodv::RoutingProtocol>::GetNeighbors (aodvTable, maxHops, actual);
+      NS_TEST_ASSERT_MSG_EQ ((actual == expected), true,
+                             "AODV reader and parser disagree at " << maxHops << " hops");
+    }
+  NS_TEST_ASSERT_MSG_EQ (actual.size (), 3, "only the live routes are neighbours");
+
+  // a broken DSDV route is invalidated with an infinite hop count
+  const Route dsdvRoutes[] = {
+    {"10.1.0.2", 1, dsdv::VALID, 0},
+    {"10.1.0.3", 2, dsdv::VALID, 0},
+    {"10.1.0.4", UINT32_MAX, dsdv::INVALID, 0},
+    {"10.1.1.5", 1, dsdv::VALID, 0},
+    {"10.1.255.255", 1, dsdv::VALID, 0},
+    {"127.0.0.1", 0, dsdv::VALID, 0},
+  };
+
+  dsdv::RoutingTable dsdvTable;
+  for (const Route &route : dsdvRoutes)
+    {
+      Ipv4Address destination (route.destination);
+      dsdv::RoutingTableEntry entry (0, destination, 2, iface, route.hops, destination);
+      entry.SetFlag (static_cast<dsdv::RouteFlags> (route.flag));
+      dsdvTable.AddRoute (entry);
+    }
+  std::ostringstream dsdvText;
+  dsdvTable.Print (Create<OutputStreamWrapper> (&dsdvText));
+
+  for (uint32_t maxHops = 1; maxHops <= 2; maxHops++)
+    {
+      ecs::Table::GetNeighbors (dsdvText.str (), ecs::TableLayout::DSDV, mask, maxHops, expected);
+      ecs::RoutingAdapter<dsdv::RoutingProtocol>::GetNeighbors (dsdvTable, maxHops, actual);
+      NS_TEST_ASSERT_MSG_EQ ((actual == expected), true,
+                             "DSDV reader and parser disagree at " << maxHops << " hops");
+    }
+  NS_TEST_ASSERT_MSG_EQ (actual.size (), 3, "wrong number of DSDV neighbours");
+}
+#endif
+
+// Checks that event refresh is only triggered by AODV and DSDV control
+// messages that add a destination within reach or break a route to one.
+class RouteChangeTestCase : public TestCase
+{
+public:
+  RouteChangeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RouteChangeTestCase::RouteChangeTestCase ()
+  : TestCase ("Event refresh follows route changes only")
+{
+}
+
+static Ptr<Packet>
+AodvMessage (aodv::MessageType type, const Header &body)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (body);
+  packet->AddHeader (aodv::TypeHeader (type));
+  return packet;
+}
+
+static Ptr<Packet>
+DsdvUpdate (const std::vector<dsdv::DsdvHeader> &entries)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  for (auto it = entries.rbegin (); it != entries.rend (); ++it)
+    {
+      packet->AddHeader (*it);
+    }
+  return packet;
+}
+
+void
+RouteChangeTestCase::DoRun (void)
+{
+  typedef ecs::RoutingAdapter<aodv::RoutingProtocol> Aodv;
+  typedef ecs::RoutingAdapter<dsdv::RoutingProtocol> Dsdv;
+
+  Ipv4Address known ("10.1.0.2");
+  Ipv4Address twoHops ("10.1.0.3");
+  Ipv4Address stranger ("10.1.0.9");
+  std::vector<uint32_t> neighbors = {known.Get (), twoHops.Get ()};
+
+  // a hello from a known neighbour only refreshes its route
+  aodv::RrepHeader hello (0, 0, known, 4, known);
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (known, AodvMessage (aodv::AODVTYPE_RREP, hello),
+                                                 2, neighbors),
+                         false, "hello from a known neighbour");
+  aodv::RrepHeader newHello (0, 0, stranger, 4, stranger);
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (stranger,
+                                                 AodvMessage (aodv::AODVTYPE_RREP, newHello), 2,
+                                                 neighbors),
+                         true, "hello from a new neighbour");
+
+  // a reply or request via a known neighbour adds a route at one hop more
+  aodv::RrepHeader reply (0, 1, stranger, 4, known);
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (known, AodvMessage (aodv::AODVTYPE_RREP, reply),
+                                                 2, neighbors),
+                         true, "reply adds a two hop route");
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (known, AodvMessage (aodv::AODVTYPE_RREP, reply),
+                                                 1, neighbors),
+                         false, "two hop route is out of reach");
+  aodv::RreqHeader request (0, 0, 1, 7, known, 0, stranger, 3);
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (known,
+                                                 AodvMessage (aodv::AODVTYPE_RREQ, request), 2,
+                                                 neighbors),
+                         true, "request adds a reverse route");
+  aodv::RreqHeader knownRequest (0, 0, 0, 7, stranger, 0, known, 3);
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (known,
+                                                 AodvMessage (aodv::AODVTYPE_RREQ, knownRequest),
+                                                 2, neighbors),
+                         false, "request from a known neighbour");
+
+  // an error only matters if it breaks a route to a neighbour
+  aodv::RerrHeader error;
+  error.AddUnDestination (stranger, 5);
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (known, AodvMessage (aodv::AODVTYPE_RERR, error),
+                                                 2, neighbors),
+                         false, "error for a destination out of reach");
+  error.AddUnDestination (twoHops, 5);
+  NS_TEST_ASSERT_MSG_EQ (Aodv::ChangesNeighbors (known, AodvMessage (aodv::AODVTYPE_RERR, error),
+                                                 2, neighbors),
+                         true, "error for a neighbour");
+
+  // a periodic DSDV update repeating known routes changes nothing
+  std::vector<dsdv::DsdvHeader> update = {dsdv::DsdvHeader (known, 0, 10),
+                                          dsdv::DsdvHeader (twoHops, 1, 6)};
+  NS_TEST_ASSERT_MSG_EQ (Dsdv::ChangesNeighbors (known, DsdvUpdate (update), 2, neighbors), false,
+                         "periodic update of known routes");
+  update.push_back (dsdv::DsdvHeader (stranger, 2, 8));
+  NS_TEST_ASSERT_MSG_EQ (Dsdv::ChangesNeighbors (known, DsdvUpdate (update), 2, neighbors), false,
+                         "three hop route is out of reach");
+  update.push_back (dsdv::DsdvHeader (stranger, 1, 8));
+  NS_TEST_ASSERT_MSG_EQ (Dsdv::ChangesNeighbors (known, DsdvUpdate (update), 2, neighbors), true,
+                         "update adds a two hop route");
+  update = {dsdv::DsdvHeader (known, 0, 12), dsdv::DsdvHeader (twoHops, 1, 7)};
+  NS_TEST_ASSERT_MSG_EQ (Dsdv::ChangesNeighbors (known, DsdvUpdate (update), 2, neighbors), true,
+                         "odd sequence number withdraws a neighbour");
+  update = {dsdv::DsdvHeader (stranger, 0, 2)};
+  NS_TEST_ASSERT_MSG_EQ (Dsdv::ChangesNeighbors (stranger, DsdvUpdate (update), 2, neighbors), true,
+                         "update from a new neighbour");
+}
+
+// Checks the vectorised intersection count against std::set_intersection and
+// that the change degree is computed from the oldest and newest snapshots.
+class ChangeDegreeTestCase : public TestCase
+{
+public:
+  ChangeDegreeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ChangeDegreeTestCase::ChangeDegreeTestCase ()
+  : TestCase ("Neighbourhood change degree uses allocation free set sizes")
+{
+}
+
+void
+ChangeDegreeTestCase::DoRun (void)
+{
+  std::vector<uint32_t> a;
+  std::vector<uint32_t> b;
+  for (uint32_t i = 0; i < 301; i++)
+    {
+      a.push_back (i * 3);
+      b.push_back (i * 2 + (i % 5 == 0));
+    }
+  std::vector<uint32_t> expected;
+  std::set_intersection (a.begin (), a.end (), b.begin (), b.end (), std::back_inserter (expected));
+  NS_TEST_ASSERT_MSG_EQ (ecs::IntersectionSize (a, b), expected.size (), "wrong intersection size");
+  NS_TEST_ASSERT_MSG_EQ (ecs::IntersectionSizeScalar (a.data (), a.size (), b.data (), b.size ()),
+                         expected.size (), "wrong scalar intersection size");
+  NS_TEST_ASSERT_MSG_EQ (ecs::UnionSize (a, b), a.size () + b.size () - expected.size (),
+                         "wrong union size");
+
+  std::string header = "AODV Routing table\nDestination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n";
+  std::string first = header
+    + "10.1.0.2\t10.1.0.2\t10.1.0.1\tUP\t+2.90s\t\t1\n"
+    + "10.1.0.3\t10.1.0.3\t10.1.0.1\tUP\t+2.90s\t\t1\n";
+  std::string second = header
+    + "10.1.0.3\t10.1.0.3\t10.1.0.1\tUP\t+2.90s\t\t1\n"
+    + "10.1.0.4\t10.1.0.4\t10.1.0.1\tUP\t+2.90s\t\t1\n";
+
+  uint32_t mask = Ipv4Mask ("255.255.0.0").Get ();
+  ecs::Table table (2, 1);
+  table.UpdateTable (first, mask, 0.1);
+  table.UpdateTable (second, mask, 0.2);
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegree (), 2.0 / 3.0, 1e-9,
+                             "one of three neighbours kept should give 2/3");
+  table.UpdateTable (second, mask, 0.3);
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegree (), 0.0, 1e-9,
+                             "unchanged neighbourhood should give 0");
+}
+
+// Check the running change degree against a full recomputation over a window
+// of snapshots, and that the deltas handed to the change callback add up
+//
+class TableDeltaTestCase : public TestCase
+{
+public:
+  TableDeltaTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void NeighborsChanged (const std::vector<uint32_t> &added, const std::vector<uint32_t> &removed);
+
+  std::set<uint32_t> m_tracked;
+  uint32_t m_calls;
+};
+
+TableDeltaTestCase::TableDeltaTestCase ()
+  : TestCase ("Incremental neighbourhood deltas match full snapshots"),
+    m_calls (0)
+{
+}
+
+void
+TableDeltaTestCase::NeighborsChanged (const std::vector<uint32_t> &added,
+                                      const std::vector<uint32_t> &removed)
+{
+  m_calls++;
+  for (uint32_t id : removed)
+    {
+      m_tracked.erase (id);
+    }
+  m_tracked.insert (added.begin (), added.end ());
+}
+
+void
+TableDeltaTestCase::DoRun (void)
+{
+  std::string header = "AODV Routing table\nDestination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n";
+  uint32_t mask = Ipv4Mask ("255.255.0.0").Get ();
+  uint32_t seed = 12345;
+
+  for (uint16_t window : {1, 2, 3, 5, 12})
+    {
+      ecs::Table table (window, 1);
+      table.SetChangeCallback (MakeCallback (&TableDeltaTestCase::NeighborsChanged, this));
+      m_tracked.clear ();
+      m_calls = 0;
+
+      std::vector<std::vector<uint32_t> > scans (window);
+      for (uint32_t round = 0; round < 200; round++)
+        {
+          std::string dump = header;
+          std::vector<uint32_t> scan;
+          for (uint32_t host = 2; host < 40; host++)
+            {
+              seed = seed * 1103515245 + 12345;
+              if ((seed >> 16) % 3 == 0)
+                {
+                  continue;
+                }
+              std::string dest = "10.1.0." + std::to_string (host);
+              dump += dest + "\t" + dest + "\t10.1.0.1\tUP\t+2.90s\t\t1\n";
+              scan.push_back (Ipv4Address (dest.c_str ()).Get ());
+            }
+
+          table.UpdateTable (dump, mask, round * 0.1);
+
+          // the oldest snapshot in the window is the one the next round overwrites
+          scans[round % window] = scan;
+          const std::vector<uint32_t> &oldest = scans[(round + 1) % window];
+          std::vector<uint32_t> both;
+          std::set_intersection (scan.begin (), scan.end (), oldest.begin (), oldest.end (),
+                                 std::back_inserter (both));
+          size_t unionSize = scan.size () + oldest.size () - both.size ();
+          double expected = unionSize == 0 ? 0 : (unionSize - both.size ()) / (double)unionSize;
+
+          NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegree (), expected, 1e-9,
+                                     "running change degree differs from a full recomputation");
+
+          // every sub-window replayed from the encoded deltas
+          for (uint16_t steps = 1; steps < window; steps++)
+            {
+              std::vector<uint32_t> past;
+              if (round >= steps)
+                {
+                  past = scans[(round - steps) % window];
+                }
+              both.clear ();
+              std::set_intersection (scan.begin (), scan.end (), past.begin (), past.end (),
+                                     std::back_inserter (both));
+              unionSize = scan.size () + past.size () - both.size ();
+              expected = unionSize == 0 ? 0 : (unionSize - both.size ()) / (double)unionSize;
+              NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegree (steps), expected, 1e-9,
+                                         "sub-window change degree differs from a full recomputation");
+            }
+          NS_TEST_ASSERT_MSG_EQ ((table.GetNeighbors () == scan), true, "wrong current neighbours");
+          NS_TEST_ASSERT_MSG_EQ ((m_tracked == std::set<uint32_t> (scan.begin (), scan.end ())),
+                                 true, "callback deltas do not add up to the current neighbours");
+        }
+      NS_TEST_ASSERT_MSG_GT (m_calls, 0, "change callback never fired");
+    }
+}
+
+// The adaptive interval stretches while the neighbourhood is quiet and snaps
+// back to the minimum on a burst of changes
+//
+class AdaptiveIntervalTestCase : public TestCase
+{
+public:
+  AdaptiveIntervalTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AdaptiveIntervalTestCase::AdaptiveIntervalTestCase ()
+  : TestCase ("Adaptive interval follows the change degree")
+{
+}
+
+void
+AdaptiveIntervalTestCase::DoRun (void)
+{
+  ecs::AdaptiveInterval interval (Seconds (1), Seconds (4), 0.5, 0.05, 0.25);
+  NS_TEST_ASSERT_MSG_EQ (interval.Get (), Seconds (1), "should start at the minimum");
+
+  NS_TEST_ASSERT_MSG_EQ (interval.Update (0), Seconds (2), "quiet neighbourhood should stretch");
+  NS_TEST_ASSERT_MSG_EQ (interval.Update (0), Seconds (4), "quiet neighbourhood should stretch");
+  NS_TEST_ASSERT_MSG_EQ (interval.Update (0), Seconds (4), "should not pass the maximum");
+
+  // above low but below high holds the interval where it is
+  NS_TEST_ASSERT_MSG_EQ (interval.Update (0.2), Seconds (4), "moderate change should hold");
+  NS_TEST_ASSERT_MSG_EQ (interval.Update (0.5), Seconds (1), "a spike should drop to the minimum");
+
+  // the smoothed degree has to decay below low before stretching again
+  NS_TEST_ASSERT_MSG_EQ (interval.Update (0), Seconds (1), "should wait for the average to settle");
+  for (int i = 0; i < 10; i++)
+    {
+      interval.Update (0);
+    }
+  NS_TEST_ASSERT_MSG_EQ (interval.Get (), Seconds (4), "should stretch again once settled");
+
+  // the change degree is taken over a time window, not a number of scans
+  std::string header = "AODV Routing table\nDestination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n";
+  std::string ab = header + "10.1.0.2\t10.1.0.2\t10.1.0.1\tUP\t+2.90s\t\t1\n"
+    + "10.1.0.3\t10.1.0.3\t10.1.0.1\tUP\t+2.90s\t\t1\n";
+  std::string ac = header + "10.1.0.2\t10.1.0.2\t10.1.0.1\tUP\t+2.90s\t\t1\n"
+    + "10.1.0.4\t10.1.0.4\t10.1.0.1\tUP\t+2.90s\t\t1\n";
+  std::string ad = header + "10.1.0.2\t10.1.0.2\t10.1.0.1\tUP\t+2.90s\t\t1\n"
+    + "10.1.0.5\t10.1.0.5\t10.1.0.1\tUP\t+2.90s\t\t1\n";
+  uint32_t mask = Ipv4Mask ("255.255.0.0").Get ();
+
+  ecs::Table table (6, 1);
+  table.UpdateTable (ab, mask, 0.1);
+  table.UpdateTable (ab, mask, 0.2);
+  table.UpdateTable (ab, mask, 0.3);
+  table.UpdateTable (ac, mask, 0.4);
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegreeOver (0.1), 2.0 / 3.0, 1e-9,
+                             "one neighbour swapped within the window");
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegreeOver (0.25), 2.0 / 3.0 * 0.25 / 0.3, 1e-9,
+                             "the snapshot at least 0.25 s old is 0.3 s old");
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegreeOver (10), 1.0, 1e-9,
+                             "a window longer than the history reaches the empty table");
+
+  // stretched scans: the same swap two seconds apart is a quarter as much
+  // change per half second
+  table.UpdateTable (ac, mask, 2.4);
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegreeOver (0.5), 0.0, 1e-9,
+                             "nothing changed since the last scan");
+  table.UpdateTable (ad, mask, 4.4);
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.ComputeChangeDegreeOver (0.5), 2.0 / 3.0 * 0.5 / 2.0, 1e-9,
+                             "change is scaled to the window");
+
+  // a ping's hello interval sets how long its row stays valid, intervals past
+  // the cap count as the cap
+  Time timeout = Seconds (2.3);
+  Time cap = Seconds (4);
+  ecs::EcsHeader ping;
+  ping.SetType (ecs::EcsHeader::PING);
+  for (uint32_t milliseconds : {500u, 1000u, 4000u, 100000u})
+    {
+      ping.SetHelloInterval (milliseconds);
+      Ptr<Packet> packet = Create<Packet> ();
+      packet->AddHeader (ping);
+      ecs::EcsHeader read;
+      packet->RemoveHeader (read);
+
+      double advertised = std::min (milliseconds, 65535u) / 1000.0;
+      double expected = std::max (2.3, 2.3 * std::min (advertised, 4.0));
+      NS_TEST_ASSERT_MSG_EQ_TOL (
+          ecs::HelloValidity (MilliSeconds (read.GetHelloInterval ()), timeout, cap).GetSeconds (),
+          expected, 1e-6, "wrong validity for a " << milliseconds << " ms hello interval");
+    }
+}
+
+// Bounded BFS over the CSR graph on a 6x6 grid, where the h-hop neighbourhood
+// of a vertex is everything within Manhattan distance h
+//
+class NeighborhoodGraphTestCase : public TestCase
+{
+public:
+  NeighborhoodGraphTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NeighborhoodGraphTestCase::NeighborhoodGraphTestCase ()
+  : TestCase ("Multi-hop neighbourhoods from the 1-hop graph")
+{
+}
+
+void
+NeighborhoodGraphTestCase::DoRun (void)
+{
+  const int side = 6;
+  ecs::NeighborhoodGraph graph;
+
+  // build twice to check the buffers are reset between ticks
+  for (int build = 0; build < 2; build++)
+    {
+      graph.Clear ();
+      for (int v = 0; v < side * side; v++)
+        {
+          std::vector<uint32_t> links;
+          int x = v % side;
+          int y = v / side;
+          if (x > 0) links.push_back (v - 1);
+          if (x < side - 1) links.push_back (v + 1);
+          if (y > 0) links.push_back (v - side);
+          if (y < side - 1) links.push_back (v + side);
+          graph.AddVertex (links.data (), links.size ());
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (graph.GetNumVertices (), (uint32_t)(side * side), "wrong vertex count");
+
+  std::vector<uint32_t> reached;
+  for (uint32_t hops = 0; hops <= 4; hops++)
+    {
+      for (int v = 0; v < side * side; v++)
+        {
+          graph.GetWithinHops (v, hops, reached);
+          std::sort (reached.begin (), reached.end ());
+
+          std::vector<uint32_t> expected;
+          for (int u = 0; u < side * side; u++)
+            {
+              int distance = std::abs (u % side - v % side) + std::abs (u / side - v / side);
+              if (u != v && distance <= (int)hops)
+                {
+                  expected.push_back (u);
+                }
+            }
+          NS_TEST_ASSERT_MSG_EQ ((reached == expected), true, "wrong h-hop neighbourhood");
+        }
+    }
+}
+
+// The spatial hash oracle against an O(n^2) range check and a plain BFS over
+// its result, with nodes on cell boundaries, at exactly the range apart and
+// in cells with negative coordinates
+//
+class NeighborOracleTestCase : public TestCase
+{
+public:
+  NeighborOracleTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Check (Ptr<ecs::NeighborOracle> oracle, const std::vector<Vector> &positions,
+              const Ipv4InterfaceContainer &addresses);
+};
+
+NeighborOracleTestCase::NeighborOracleTestCase ()
+  : TestCase ("Neighbour oracle matches a brute force range check")
+{
+}
+
+static const double ORACLE_RANGE = 250.0;
+
+void
+NeighborOracleTestCase::Check (Ptr<ecs::NeighborOracle> oracle,
+                               const std::vector<Vector> &positions,
+                               const Ipv4InterfaceContainer &addresses)
+{
+  uint32_t n = positions.size ();
+  std::vector<std::vector<uint32_t> > links (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      for (uint32_t j = 0; j < n; j++)
+        {
+          double dx = positions[i].x - positions[j].x;
+          double dy = positions[i].y - positions[j].y;
+          if (i != j && dx * dx + dy * dy <= ORACLE_RANGE * ORACLE_RANGE)
+            {
+              links[i].push_back (j);
+            }
+        }
+    }
+
+  std::vector<uint32_t> neighbors;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // breadth first over the brute force links, one ring per hop
+      std::vector<uint32_t> hops (n, UINT32_MAX);
+      std::vector<uint32_t> ring = {i};
+      hops[i] = 0;
+      for (uint32_t maxHops = 1; maxHops <= 3; maxHops++)
+        {
+          std::vector<uint32_t> next;
+          for (uint32_t v : ring)
+            {
+              for (uint32_t w : links[v])
+                {
+                  if (hops[w] == UINT32_MAX)
+                    {
+                      hops[w] = maxHops;
+                      next.push_back (w);
+                    }
+                }
+            }
+          ring.swap (next);
+
+          std::vector<uint32_t> expected;
+          for (uint32_t j = 0; j < n; j++)
+            {
+              if (j != i && hops[j] <= maxHops)
+                {
+                  expected.push_back (addresses.GetAddress (j).Get ());
+                }
+            }
+          std::sort (expected.begin (), expected.end ());
+
+          oracle->GetNeighbors (addresses.GetAddress (i).Get (), maxHops, neighbors);
+          NS_TEST_ASSERT_MSG_EQ ((neighbors == expected), true,
+                                 "node " << i << " at " << maxHops << " hops");
+        }
+    }
+}
+
+void
+NeighborOracleTestCase::DoRun (void)
+{
+  // cells are one range wide, so multiples of 250 are on their edges
+  std::vector<Vector> positions = {
+    Vector (0, 0, 0),       Vector (250, 0, 0),     Vector (150, 200, 0),  Vector (500, 0, 0),
+    Vector (-250, 0, 0),    Vector (0, -250, 0),    Vector (250, 250, 0),  Vector (-250, -250, 0),
+    Vector (750, 0, 0),     Vector (500, 250.5, 0), Vector (-0.5, 0, 0),   Vector (1000, 1000, 0),
+  };
+  uint32_t seed = 2024;
+  while (positions.size () < 120)
+    {
+      seed = seed * 1103515245 + 12345;
+      double x = (seed >> 8) % 2000 - 600.0;
+      seed = seed * 1103515245 + 12345;
+      double y = (seed >> 8) % 2000 - 600.0;
+      // every other node snapped to a 50 m grid, so many pairs sit exactly
+      // on a cell edge or exactly the range apart
+      if (positions.size () % 2 == 0)
+        {
+          x = std::round (x / 50) * 50;
+          y = std::round (y / 50) * 50;
+        }
+      positions.push_back (Vector (x, y, 0));
+    }
+
+  NodeContainer nodes;
+  nodes.Create (positions.size ());
+  SimpleNetDeviceHelper devices;
+  NetDeviceContainer interfaces = devices.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.0.0");
+  Ipv4InterfaceContainer addresses = ipv4.Assign (interfaces);
+
+  std::vector<Ptr<ConstantPositionMobilityModel> > mobility;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      mobility.push_back (CreateObject<ConstantPositionMobilityModel> ());
+      mobility[i]->SetPosition (positions[i]);
+      nodes.Get (i)->AggregateObject (mobility[i]);
+    }
+
+  Ptr<ecs::NeighborOracle> oracle = CreateObject<ecs::NeighborOracle> ();
+  oracle->SetAttribute ("Range", DoubleValue (ORACLE_RANGE));
+  oracle->Add (nodes);
+  Check (oracle, positions, addresses);
+
+  // move everything and let the grid go stale, the next query rebuilds it
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      positions[i].x += (i % 7) * 25.0 - 75.0;
+      positions[i].y -= (i % 5) * 50.0;
+      mobility[i]->SetPosition (positions[i]);
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  Check (oracle, positions, addresses);
+
+  Simulator::Destroy ();
+}
+
+// Random upserts and erases on the information table checked against a
+// std::map, with ids that collide in the index and enough rows to rehash,
+// along with the per status counts and walks
+//
+class InformationTableTestCase : public TestCase
+{
+public:
+  InformationTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+InformationTableTestCase::InformationTableTestCase ()
+  : TestCase ("Information table keeps one row per node")
+{
+}
+
+static double g_testClock = 0;
+
+static double
+TestClock (void)
+{
+  return g_testClock;
+}
+
+struct TestRow
+{
+  uint32_t nodeID;
+  uint32_t status;
+  uint32_t value;
+  double entryTime;
+  double validTime;
+};
+
+void
+InformationTableTestCase::DoRun (void)
+{
+  const uint32_t statuses = 3;
+  ecs::InformationTable<TestRow, statuses> table;
+  std::map<uint32_t, TestRow> expected;
+
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      uint32_t id = 0x0a010000 + (seed >> 16) % 300;
+      if ((seed >> 8) % 4 == 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (table.Erase (id), expected.erase (id) == 1, "erase disagrees");
+        }
+      else
+        {
+          TestRow& row = table.Upsert ({id, i % statuses, i});
+          NS_TEST_ASSERT_MSG_EQ (row.value, i, "upsert should return the written row");
+          expected[id] = row;
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (table.size (), expected.size (), "one row per node");
+
+  for (auto it = expected.begin (); it != expected.end (); ++it)
+    {
+      TestRow* row = table.Find (it->first);
+      NS_TEST_ASSERT_MSG_EQ ((row != nullptr), true, "row went missing");
+      NS_TEST_ASSERT_MSG_EQ (row->value, it->second.value, "row holds a stale value");
+    }
+
+  for (uint32_t status = 0; status < statuses; status++)
+    {
+      size_t count = 0;
+      TestRow* last = nullptr;
+      for (auto it = expected.begin (); it != expected.end (); ++it)
+        {
+          if (it->second.status != status) continue;
+          count++;
+          if (last == nullptr || it->second.value > last->value) last = &it->second;
+        }
+      NS_TEST_ASSERT_MSG_EQ (table.Count (status), count, "status count drifted");
+      NS_TEST_ASSERT_MSG_EQ ((table.Last (status) != nullptr), (last != nullptr), "last row of status");
+      if (last != nullptr)
+        {
+          NS_TEST_ASSERT_MSG_EQ (table.Last (status)->nodeID, last->nodeID, "wrong last row of status");
+        }
+
+      size_t walked = 0;
+      for (auto it = table.begin (status); it != table.end (); ++it, walked++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (it->status, status, "row walked under the wrong status");
+        }
+      NS_TEST_ASSERT_MSG_EQ (walked, count, "status walk missed rows");
+    }
+
+  // walked in the order the rows were last written
+  uint32_t last = 0;
+  size_t walked = 0;
+  for (auto it = table.begin (); it != table.end (); ++it, walked++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((walked == 0 || it->value > last), true, "walk out of write order");
+      last = it->value;
+    }
+  NS_TEST_ASSERT_MSG_EQ (walked, expected.size (), "walk missed rows");
+
+  std::vector<uint32_t> ids;
+  table.GetIds (ids);
+  std::vector<uint32_t> expectedIds;
+  for (auto it = expected.begin (); it != expected.end (); ++it)
+    {
+      expectedIds.push_back (it->first);
+    }
+  NS_TEST_ASSERT_MSG_EQ ((ids == expectedIds), true, "ids should come back sorted");
+
+  // erase every odd id while walking
+  for (auto it = table.begin (); it != table.end ();)
+    {
+      if (it->nodeID % 2)
+        {
+          expected.erase (it->nodeID);
+          it = table.Erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (table.size (), expected.size (), "erase while walking");
+  NS_TEST_ASSERT_MSG_EQ (table.Count (0) + table.Count (1) + table.Count (2), table.size (),
+                         "status counts should follow erases");
+
+  // expire on the wheel against a walk of the whole table, with rows that
+  // are refreshed, rows more than a turn ahead and steps that skip ticks
+  ecs::InformationTable<TestRow, statuses> timed (0.1, 16);
+  std::map<uint32_t, TestRow> live;
+  double now = 0;
+  for (uint32_t i = 0; i < 3000; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      uint32_t id = (seed >> 16) % 200;
+      double validTime = ((seed >> 4) % 40) / 10.0;
+      timed.Upsert ({id, i % statuses, i, now, validTime});
+      live[id] = {id, i % statuses, i, now, validTime};
+
+      if (i % 10 == 0)
+        {
+          now += ((seed >> 12) % 8) * 0.07;
+          double next = DBL_MAX;
+          for (auto it = live.begin (); it != live.end (); ++it)
+            {
+              next = std::min (next, it->second.entryTime + it->second.validTime);
+            }
+          NS_TEST_ASSERT_MSG_EQ (timed.NextExpiry (), next, "wrong next expiry");
+
+          size_t before = live.size ();
+          for (auto it = live.begin (); it != live.end ();)
+            {
+              // expiry is resolved to the millisecond
+              if (std::llround (now * 1000) > std::llround ((it->second.entryTime + it->second.validTime) * 1000))
+                it = live.erase (it);
+              else
+                ++it;
+            }
+          NS_TEST_ASSERT_MSG_EQ (timed.Expire (now), before - live.size (), "wrong number expired");
+          NS_TEST_ASSERT_MSG_EQ (timed.size (), live.size (), "expired rows disagree");
+        }
+    }
+
+  // the census and sweep stream over the columns instead of the lists
+  now += 1;
+  size_t census[statuses];
+  timed.Census (now, census);
+  size_t expectedCensus[statuses] = {};
+  size_t stale = 0;
+  for (auto it = live.begin (); it != live.end (); ++it)
+    {
+      if (std::llround (now * 1000) > std::llround ((it->second.entryTime + it->second.validTime) * 1000))
+        stale++;
+      else
+        expectedCensus[it->second.status]++;
+    }
+  for (uint32_t status = 0; status < statuses; status++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (census[status], expectedCensus[status], "census disagrees");
+    }
+  NS_TEST_ASSERT_MSG_EQ (timed.Sweep (now), stale, "sweep disagrees");
+  NS_TEST_ASSERT_MSG_EQ (timed.size (), live.size () - stale, "sweep left stale rows");
+
+  // lazy expiry, stale rows vanish from reads without Expire being called
+  // and the table is compacted once half of it has been found stale
+  ecs::InformationTable<TestRow, statuses> lazy;
+  lazy.SetLazyExpiry (&TestClock, 0.5);
+  g_testClock = 0;
+  for (uint32_t id = 0; id < 100; id++)
+    {
+      lazy.Upsert ({id, id % statuses, id, 0, id < 60 ? 1.0 : 5.0});
+    }
+  NS_TEST_ASSERT_MSG_EQ (lazy.size (), 100, "nothing is stale yet");
+
+  g_testClock = 2;
+  NS_TEST_ASSERT_MSG_EQ ((lazy.Find (10) == nullptr), true, "stale row should not be found");
+  NS_TEST_ASSERT_MSG_EQ ((lazy.Find (70) != nullptr), true, "live row should be found");
+  NS_TEST_ASSERT_MSG_EQ (lazy.Count (1), 13, "only live rows are counted");
+  NS_TEST_ASSERT_MSG_EQ (lazy.size (), 40, "only live rows are walked");
+  NS_TEST_ASSERT_MSG_EQ (lazy.GetNumBuried (), 60, "reads should mark the stale rows");
+  NS_TEST_ASSERT_MSG_EQ (lazy.Last (0)->nodeID, 99, "last live row of status");
+
+  // refreshing a stale row brings it back, the next write compacts the rest
+  lazy.Upsert ({10, 1, 0, 2, 1.0});
+  NS_TEST_ASSERT_MSG_EQ (lazy.GetNumBuried (), 0, "compaction should reclaim the stale rows");
+  lazy.Upsert ({5, 2, 0, 2, 1.0});
+  NS_TEST_ASSERT_MSG_EQ (lazy.size (), 42, "refreshed rows are live again");
+  NS_TEST_ASSERT_MSG_EQ ((lazy.Find (10) != nullptr), true, "refreshed row should be found");
+
+  // lazy counts stay exact as rows go stale, are marked, change status and
+  // are reclaimed, checked against the rows themselves at every step
+  ecs::InformationTable<TestRow, statuses> counted (0.1, 16);
+  counted.SetLazyExpiry (&TestClock, 0.25);
+  std::map<uint32_t, TestRow> rows;
+  for (uint32_t step = 0; step < 200; step++)
+    {
+      g_testClock = step * 0.05;
+      for (uint32_t k = 0; k < 3; k++)
+        {
+          uint32_t id = (step * 7 + k * 13) % 40;
+          TestRow row = {id, (step + k) % statuses, step, g_testClock, 0.1 + (step * k % 9) * 0.2};
+          counted.Upsert (row);
+          rows[id] = row;
+        }
+      counted.Find ((step * 11) % 40);
+
+      size_t expected[statuses] = {};
+      size_t total = 0;
+      for (auto it = rows.begin (); it != rows.end (); ++it)
+        {
+          if (llround (g_testClock * 1000) <= llround ((it->second.entryTime + it->second.validTime) * 1000))
+            {
+              expected[it->second.status]++;
+              total++;
+            }
+        }
+      for (size_t status = 0; status < statuses; status++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (counted.Count (status), expected[status], "lazy count disagrees");
+        }
+      NS_TEST_ASSERT_MSG_EQ (counted.size (), total, "lazy size disagrees");
+    }
+
+  for (uint32_t id = 0x0a010000; id < 0x0a010000 + 300; id++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((table.Find (id) != nullptr), (expected.count (id) == 1), "find disagrees");
+    }
+}
+
+// A cluster head's membership index fed with the heads each node names
+//
+class ClusterMembershipTestCase : public TestCase
+{
+public:
+  ClusterMembershipTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ClusterMembershipTestCase::ClusterMembershipTestCase ()
+  : TestCase ("Cluster membership tracks joins, gateways and tenure")
+{
+}
+
+void
+ClusterMembershipTestCase::DoRun (void)
+{
+  const uint32_t head = 1;
+  const uint32_t onlyHead[] = {head};
+  const uint32_t twoHeads[] = {7, head};
+
+  ecs::ClusterMembership members;
+  NS_TEST_ASSERT_MSG_EQ (members.GetSize (), 0, "should start empty");
+  NS_TEST_ASSERT_MSG_EQ (members.GetMeanTenure (1.0), 0, "empty cluster has no tenure");
+
+  members.Update (10, head, onlyHead, 1, 1.0, 2.0);
+  members.Update (11, head, onlyHead, 1, 2.0, 2.0);
+  members.Update (12, head, twoHeads, 2, 2.0, 2.0);
+  NS_TEST_ASSERT_MSG_EQ (members.GetSize (), 3, "three nodes joined");
+  NS_TEST_ASSERT_MSG_EQ (members.GetNumGateways (), 1, "naming another head makes a gateway");
+  NS_TEST_ASSERT_MSG_EQ (members.Find (12)->numOtherHeads, 1, "the head itself is not another head");
+  NS_TEST_ASSERT_MSG_EQ (members.Find (12)->otherHeads[0], 7, "other head of the gateway");
+
+  // hearing from a member again keeps when it joined
+  members.Update (10, head, onlyHead, 1, 2.5, 2.0);
+  NS_TEST_ASSERT_MSG_EQ (members.Find (10)->joinTime, 1.0, "refresh should keep the join time");
+  NS_TEST_ASSERT_MSG_EQ (members.GetMeanTenure (3.0), (2.0 + 1.0 + 1.0) / 3, "mean tenure");
+
+  // a gateway that drops its other head is a plain member again
+  members.Update (12, head, onlyHead, 1, 2.5, 2.0);
+  NS_TEST_ASSERT_MSG_EQ (members.GetNumGateways (), 0, "gateway became a member");
+  NS_TEST_ASSERT_MSG_EQ (members.begin (ecs::ClusterMembership::MEMBER) == members.end (), false,
+                         "members should be walkable");
+
+  NS_TEST_ASSERT_MSG_EQ (members.Leave (11), true, "member should leave");
+  NS_TEST_ASSERT_MSG_EQ (members.Leave (11), false, "cannot leave twice");
+  NS_TEST_ASSERT_MSG_EQ (members.GetMeanTenure (3.0), (2.0 + 1.0) / 2, "tenure without the leaver");
+
+  // 10 and 12 were last heard from at 2.5 and go stale after 4.5
+  NS_TEST_ASSERT_MSG_EQ (members.Expire (4.0), 0, "nothing stale yet");
+  members.Update (13, head, onlyHead, 1, 4.0, 2.0);
+  NS_TEST_ASSERT_MSG_EQ (members.Expire (5.0), 2, "both old members should expire");
+  NS_TEST_ASSERT_MSG_EQ (members.GetSize (), 1, "only the newcomer is left");
+  NS_TEST_ASSERT_MSG_EQ (members.GetMeanTenure (5.0), 1.0, "tenure of the newcomer");
+
+  // heard from again after going stale is a fresh join
+  members.Update (13, head, onlyHead, 1, 6.5, 2.0);
+  NS_TEST_ASSERT_MSG_EQ (members.Find (13)->joinTime, 6.5, "stale member rejoins");
+  NS_TEST_ASSERT_MSG_EQ (members.GetMeanTenure (7.0), 0.5, "tenure restarts on rejoin");
+
+  members.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (members.GetSize (), 0, "clear should empty the cluster");
+  NS_TEST_ASSERT_MSG_EQ (members.GetMeanTenure (7.0), 0, "clear should reset the tenure");
+}
+
+// Per-sender anti-replay window over (origin, sequence) message ids
+//
+class ReplayWindowTestCase : public TestCase
+{
+public:
+  ReplayWindowTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ReplayWindowTestCase::ReplayWindowTestCase ()
+  : TestCase ("Replay window drops repeated and stale message ids")
+{
+}
+
+void
+ReplayWindowTestCase::DoRun (void)
+{
+  const uint32_t a = 0x0a010001;
+  const uint32_t b = 0x0a010002;
+  NS_TEST_ASSERT_MSG_EQ (ecs::GetMessageOrigin (ecs::MakeMessageId (a, 5)), a, "origin round trip");
+  NS_TEST_ASSERT_MSG_EQ (ecs::GetMessageSequence (ecs::MakeMessageId (a, 5)), 5, "sequence round trip");
+
+  ecs::ReplayWindow window;
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 1), 0), false, "first message");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 1), 0), true, "repeat");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (b, 1), 0), false, "senders are separate");
+
+  // out of order within the window is accepted once
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 10), 0), false, "jump ahead");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 4), 0), false, "late but new");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 4), 0), true, "late repeat");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 10), 0), true, "highest repeat");
+
+  // sliding past the window drops the older ids
+  uint32_t top = 10 + ecs::ReplayWindow::WINDOW;
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, top), 0), false, "slide");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 10), 0), true, "outside the window");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 11), 0), false, "oldest in the window");
+
+  // every id in a shuffled run is accepted exactly once
+  std::vector<uint32_t> sequence;
+  for (uint32_t i = 1; i <= 500; i++)
+    {
+      sequence.push_back (i);
+    }
+  for (size_t i = 0; i + 8 <= sequence.size (); i += 8)
+    {
+      std::reverse (sequence.begin () + i, sequence.begin () + i + 8);
+    }
+  size_t accepted = 0;
+  for (int pass = 0; pass < 2; pass++)
+    {
+      for (uint32_t s : sequence)
+        {
+          accepted += !window.CheckDuplicate (ecs::MakeMessageId (b, s + 1), 1);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (accepted, 500, "each reordered id should be accepted once");
+
+  // sequence numbers wrap around
+  ecs::ReplayWindow wrap;
+  wrap.CheckDuplicate (ecs::MakeMessageId (a, UINT32_MAX - 1), 0);
+  NS_TEST_ASSERT_MSG_EQ (wrap.CheckDuplicate (ecs::MakeMessageId (a, 1), 0), false, "wrapped id is new");
+  NS_TEST_ASSERT_MSG_EQ (wrap.CheckDuplicate (ecs::MakeMessageId (a, UINT32_MAX), 0), false, "late before the wrap");
+  NS_TEST_ASSERT_MSG_EQ (wrap.CheckDuplicate (ecs::MakeMessageId (a, UINT32_MAX - 1), 0), true, "repeat before the wrap");
+
+  // quiet senders are forgotten
+  NS_TEST_ASSERT_MSG_EQ (window.GetNumSenders (), 2, "two senders");
+  NS_TEST_ASSERT_MSG_EQ (window.Expire (0.5), 1, "sender a went quiet");
+  NS_TEST_ASSERT_MSG_EQ (window.GetNumSenders (), 1, "only b is left");
+  NS_TEST_ASSERT_MSG_EQ (window.CheckDuplicate (ecs::MakeMessageId (a, 1), 2), false, "a starts over");
+}
+
+// Rotating Bloom filter stays within its memory and false positive budget
+//
+class DuplicateFilterTestCase : public TestCase
+{
+public:
+  DuplicateFilterTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DuplicateFilterTestCase::DuplicateFilterTestCase ()
+  : TestCase ("Duplicate filter bounds memory and false drops")
+{
+}
+
+void
+DuplicateFilterTestCase::DoRun (void)
+{
+  ecs::DuplicateFilter filter (1024, 0.01, 10);
+  NS_TEST_ASSERT_MSG_EQ (filter.GetMemory (), 1024, "memory budget should be used exactly");
+  NS_TEST_ASSERT_MSG_EQ ((filter.GetNumHashes () >= 1), true, "at least one hash");
+
+  // no false negatives while ids stay within a generation's capacity
+  size_t capacity = filter.GetCapacity ();
+  for (uint32_t i = 1; i <= capacity; i++)
+    {
+      filter.CheckDuplicate (ecs::MakeMessageId (7, i), 0);
+    }
+  for (uint32_t i = 1; i <= capacity; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (filter.CheckDuplicate (ecs::MakeMessageId (7, i), 0), true, "seen id missed");
+    }
+
+  // a steady stream of new ids keeps rotating, the drop rate stays near the target
+  size_t dropped = 0;
+  const size_t fresh = 20000;
+  for (uint32_t i = 1; i <= fresh; i++)
+    {
+      dropped += filter.CheckDuplicate (ecs::MakeMessageId (9, i), 1);
+    }
+  NS_TEST_ASSERT_MSG_EQ ((dropped < fresh * 0.02), true, "too many new ids dropped");
+  NS_TEST_ASSERT_MSG_EQ ((filter.GetOccupancy () <= 0.6), true, "rotation should bound occupancy");
+  NS_TEST_ASSERT_MSG_EQ ((std::fabs (filter.GetEstimatedFalseDrops () - dropped) <= 3 * std::sqrt (dropped + 1.0) + 3),
+                         true, "false drop estimate should track the real drops");
+  NS_TEST_ASSERT_MSG_EQ (filter.GetMemory (), 1024, "memory must not grow");
+
+  // ids age out once two periods pass
+  ecs::DuplicateFilter timed (1024, 0.01, 1);
+  timed.CheckDuplicate (42, 0);
+  NS_TEST_ASSERT_MSG_EQ (timed.CheckDuplicate (42, 0.5), true, "within the period");
+  NS_TEST_ASSERT_MSG_EQ (timed.CheckDuplicate (42, 1.5), true, "old generation still answers");
+  NS_TEST_ASSERT_MSG_EQ (timed.CheckDuplicate (43, 3.0), false, "new id after rotating");
+  NS_TEST_ASSERT_MSG_EQ (timed.CheckDuplicate (42, 4.5), false, "forgotten after two periods quiet");
+
+  timed.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (timed.GetOccupancy (), 0, "clear should empty the filter");
+}
+
+// Every message type survives a round trip through a packet in the binary
+// wire format, and malformed packets are rejected
+//
+class EcsHeaderTestCase : public TestCase
+{
+public:
+  EcsHeaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EcsHeaderTestCase::EcsHeaderTestCase ()
+  : TestCase ("Binary wire format round trips every message")
+{
+}
+
+void
+EcsHeaderTestCase::DoRun (void)
+{
+  ecs::EcsHeader ping;
+  ping.SetType (ecs::EcsHeader::PING);
+  ping.SetId (ecs::MakeMessageId (0x0a010001, 77));
+  ping.SetTimestamp (123456);
+  ping.SetNodeStatus (3);
+  ping.SetHelloInterval (1500);
+  ping.AddHead (0x0a010002);
+  ping.AddHead (0x0a010003);
+  NS_TEST_ASSERT_MSG_EQ (ping.GetSerializedSize (), 14 + 2 + 1 + 8, "ping size");
+
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (ping);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), ping.GetSerializedSize (), "packet holds just the header");
+
+  ecs::EcsHeader read;
+  packet->RemoveHeader (read);
+  NS_TEST_ASSERT_MSG_EQ (read.GetType (), ecs::EcsHeader::PING, "type");
+  NS_TEST_ASSERT_MSG_EQ (read.GetId (), ping.GetId (), "id");
+  NS_TEST_ASSERT_MSG_EQ (read.GetTimestamp (), 123456, "timestamp");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) read.GetNodeStatus (), 3, "node status");
+  NS_TEST_ASSERT_MSG_EQ (read.GetHelloInterval (), 1500, "hello interval");
+  NS_TEST_ASSERT_MSG_EQ (read.GetNumHeads (), 2, "head count");
+  NS_TEST_ASSERT_MSG_EQ (read.GetHeads ()[1], 0x0a010003, "heads");
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 0, "the whole header is consumed");
+
+  ecs::EcsHeader meeting;
+  meeting.SetType (ecs::EcsHeader::MEETING);
+  meeting.SetTableSize (42);
+  packet = Create<Packet> ();
+  packet->AddHeader (meeting);
+  packet->RemoveHeader (read);
+  NS_TEST_ASSERT_MSG_EQ (read.GetType (), ecs::EcsHeader::MEETING, "meeting type");
+  NS_TEST_ASSERT_MSG_EQ (read.GetTableSize (), 42, "table size");
+  NS_TEST_ASSERT_MSG_EQ (read.GetNumHeads (), 0, "heads are not carried over");
+
+  ecs::EcsHeader claim;
+  claim.SetType (ecs::EcsHeader::CLAIM);
+  NS_TEST_ASSERT_MSG_EQ (claim.GetSerializedSize (), ecs::EcsHeader::FIXED_SIZE, "claim has no payload");
+
+  // the header keeps every head but the binary encoding carries a bounded
+  // list, the hello interval saturates
+  ecs::EcsHeader status;
+  status.SetType (ecs::EcsHeader::STATUS);
+  status.SetHelloInterval (100000);
+  NS_TEST_ASSERT_MSG_EQ (status.GetHelloInterval (), 65535, "hello interval saturates");
+  for (uint32_t h = 0; h <= ecs::EcsHeader::MAX_HEADS; h++)
+    {
+      status.AddHead (h);
+    }
+  NS_TEST_ASSERT_MSG_EQ (status.GetNumHeads (), ecs::EcsHeader::MAX_HEADS + 1, "the header is not bounded");
+  NS_TEST_ASSERT_MSG_EQ (status.GetHeads ()[0], 0, "the inline heads move with the rest");
+  NS_TEST_ASSERT_MSG_EQ (status.GetHeads ()[ecs::EcsHeader::MAX_HEADS], ecs::EcsHeader::MAX_HEADS, "heads past the inline ones");
+  NS_TEST_ASSERT_MSG_EQ (status.GetSerializedSize (), ecs::EcsHeader::FIXED_SIZE + 5 + 4 * ecs::EcsHeader::MAX_HEADS,
+                         "only the bounded list is encoded");
+
+  // headers delimit themselves, a frame of several messages reads back in order
+  status.SetRecipient (0x0a010009);
+  packet = Create<Packet> ();
+  packet->AddHeader (meeting);
+  packet->AddHeader (status);
+  packet->AddHeader (ping);
+  std::vector<ecs::EcsHeader::Type> types;
+  while (packet->GetSize () > 0)
+    {
+      packet->RemoveHeader (read);
+      types.push_back (read.GetType ());
+      if (read.GetType () == ecs::EcsHeader::STATUS)
+        {
+          NS_TEST_ASSERT_MSG_EQ (read.GetRecipient (), 0x0a010009, "status recipient");
+          NS_TEST_ASSERT_MSG_EQ (read.GetNumHeads (), ecs::EcsHeader::MAX_HEADS, "full head list");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (types.size (), 3, "three messages in the frame");
+  NS_TEST_ASSERT_MSG_EQ (types[0], ecs::EcsHeader::PING, "first message");
+  NS_TEST_ASSERT_MSG_EQ (types[2], ecs::EcsHeader::MEETING, "last message");
+
+  // a truncated packet or an unknown type is not a message
+  packet = Create<Packet> ();
+  packet->AddHeader (status);
+  std::vector<uint8_t> bytes (packet->GetSize ());
+  packet->CopyData (bytes.data (), bytes.size ());
+  Ptr<Packet> truncated = Create<Packet> (bytes.data (), bytes.size () - 1);
+  truncated->RemoveHeader (read);
+  NS_TEST_ASSERT_MSG_EQ (read.GetType (), ecs::EcsHeader::INVALID, "truncated status");
+  Ptr<Packet> tiny = Create<Packet> (bytes.data (), 5);
+  tiny->RemoveHeader (read);
+  NS_TEST_ASSERT_MSG_EQ (read.GetType (), ecs::EcsHeader::INVALID, "shorter than the fixed fields");
+  bytes[0] = 200;
+  Ptr<Packet> unknown = Create<Packet> (bytes.data (), bytes.size ());
+  unknown->RemoveHeader (read);
+  NS_TEST_ASSERT_MSG_EQ (read.GetType (), ecs::EcsHeader::INVALID, "unknown type");
+}
+
+namespace ecs {
+
+// ecsClusterApp lets the tests in through this class alone. Each function
+// hands out one piece of the app's state or runs one of its private steps.
+class ecsClusterAppTestAccess
+{
+public:
+  typedef std::vector<std::pair<uint32_t, Ptr<Packet> > > Queue;
+
+  static const uint32_t BROADCAST = ecsClusterApp::BROADCAST;
+
+  static uint32_t &Address (ecsClusterApp &app) { return app.m_address; }
+  static ecsClusterApp::WireFormat &Format (ecsClusterApp &app) { return app.m_wire_format; }
+  static Time &HelloTimeout (ecsClusterApp &app) { return app.m_hello_message_timeout; }
+  static Time &CoalesceWindow (ecsClusterApp &app) { return app.m_coalesce_window; }
+  static Time &PiggybackDelay (ecsClusterApp &app) { return app.m_piggyback_delay; }
+  static ecsClusterApp::HelloMode &HelloMode (ecsClusterApp &app) { return app.m_hello_mode; }
+  static TrickleTimer &Trickle (ecsClusterApp &app) { return app.m_trickle; }
+  static Time &HelloCoveredUntil (ecsClusterApp &app) { return app.m_hello_covered_until; }
+  static EventId &HelloEvent (ecsClusterApp &app) { return app.m_hello_event; }
+  static uint32_t MessageSequence (ecsClusterApp &app) { return app.m_message_sequence; }
+  static InformationTable<ecsClusterApp::InformationTableRow, ecsClusterApp::NUM_NODE_STATUSES> &
+  Table (ecsClusterApp &app) { return app.m_informationTable; }
+  static Queue &Outbound (ecsClusterApp &app) { return app.m_outbound; }
+  static Queue &Piggybacked (ecsClusterApp &app) { return app.m_piggybacked; }
+  static ClusterMembership &Members (ecsClusterApp &app) { return app.m_members; }
+
+  static Ptr<Packet> GeneratePing (ecsClusterApp &app, uint8_t status) { return app.GeneratePing (status); }
+  static Ptr<Packet> GenerateStatus (ecsClusterApp &app, uint8_t status, uint32_t recipient)
+  {
+    return app.GenerateStatus (status, recipient);
+  }
+  static Ptr<Packet> GenerateClusterHeadClaim (ecsClusterApp &app) { return app.GenerateClusterHeadClaim (); }
+  static void QueueMessage (ecsClusterApp &app, uint32_t destination, Ptr<Packet> packet)
+  {
+    app.QueueMessage (destination, packet);
+  }
+  static void SendPing (ecsClusterApp &app, uint8_t status) { app.SendPing (status); }
+  static void SendClusterHeadClaim (ecsClusterApp &app) { app.SendClusterHeadClaim (); }
+  static void CheckCHShouldResign (ecsClusterApp &app) { app.CheckCHShouldResign (); }
+  static void TrickleHello (Ptr<ecsClusterApp> app) { app->TrickleHello (); }
+  static void CheckPiggybackDeadline (ecsClusterApp &app) { app.CheckPiggybackDeadline (); }
+  static bool DecodeFrame (ecsClusterApp &app, Ptr<Packet> packet, std::vector<EcsHeader> &frame)
+  {
+    return app.DecodeFrame (packet, frame);
+  }
+};
+
+} // namespace ecs
+
+typedef ecs::ecsClusterAppTestAccess Access;
+
+// Hellos are encoded once per status and patched with a fresh id and
+// timestamp, every copy has to decode to the message that would have been
+// built from scratch
+//
+class HelloTemplateTestCase : public TestCase
+{
+public:
+  HelloTemplateTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void CheckPings (Ptr<ecs::ecsClusterApp> app);
+};
+
+HelloTemplateTestCase::HelloTemplateTestCase ()
+  : TestCase ("Patched hello templates decode to fresh pings")
+{
+}
+
+static const uint32_t HELLO_SENDER = 0x0a010001;
+static const uint32_t HELLO_HEAD = 0x0a010005;
+
+void
+HelloTemplateTestCase::CheckPings (Ptr<ecs::ecsClusterApp> app)
+{
+  std::vector<ecs::EcsHeader> frame;
+  for (uint8_t status = 0; status < ecs::ecsClusterApp::NUM_NODE_STATUSES; status++)
+    {
+      uint64_t id = ecs::MakeMessageId (HELLO_SENDER, Access::MessageSequence (*app) + 1);
+      Ptr<Packet> packet = Access::GeneratePing (*app, status);
+      NS_TEST_ASSERT_MSG_EQ (Access::DecodeFrame (*app, packet, frame), true, "hello should decode");
+      NS_TEST_ASSERT_MSG_EQ (frame.size (), 1, "one message in the frame");
+      NS_TEST_ASSERT_MSG_EQ (frame[0].GetType (), ecs::EcsHeader::PING, "hello is a ping");
+      NS_TEST_ASSERT_MSG_EQ (frame[0].GetId (), id, "patched id");
+      NS_TEST_ASSERT_MSG_EQ (frame[0].GetTimestamp (), Simulator::Now ().GetMilliSeconds (), "patched timestamp");
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)frame[0].GetNodeStatus (), (uint32_t)status, "node status");
+      NS_TEST_ASSERT_MSG_EQ (frame[0].GetHelloInterval (), 1000, "hello interval");
+
+      // members and gateways name their heads
+      bool member = status == 2 || status == 3;
+      NS_TEST_ASSERT_MSG_EQ (frame[0].GetNumHeads (), member ? 1 : 0, "heads");
+      if (member)
+        {
+          NS_TEST_ASSERT_MSG_EQ (frame[0].GetHeads ()[0], HELLO_HEAD, "head");
+        }
+    }
+}
+
+void
+HelloTemplateTestCase::DoRun (void)
+{
+  const ecs::ecsClusterApp::WireFormat formats[] = {ecs::ecsClusterApp::WIRE_PROTOBUF,
+                                                     ecs::ecsClusterApp::WIRE_BINARY};
+  for (ecs::ecsClusterApp::WireFormat format : formats)
+    {
+      Ptr<ecs::ecsClusterApp> app = CreateObject<ecs::ecsClusterApp> ();
+      Access::Format (*app) = format;
+      Access::Address (*app) = HELLO_SENDER;
+      Access::HelloTimeout (*app) = MilliSeconds (1000);
+      Access::Table (*app).Upsert ({HELLO_HEAD, ecs::ecsClusterApp::Node_Status::CLUSTER_HEAD,
+                                       HELLO_HEAD, 0, 0, 1000});
+
+      // the first round builds the templates, the later ones only patch them
+      for (uint32_t round = 0; round < 3; round++)
+        {
+          Simulator::Schedule (MilliSeconds (1 + 1234 * round), &HelloTemplateTestCase::CheckPings, this, app);
+        }
+      Simulator::Run ();
+      Simulator::Destroy ();
+    }
+}
+
+// A hello carrying replies that is coalesced behind another message still
+// delivers every message of the frame
+//
+class CoalescingTestCase : public TestCase
+{
+public:
+  CoalescingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CoalescingTestCase::CoalescingTestCase ()
+  : TestCase ("Coalesced frames decode to every message sent")
+{
+}
+
+void
+CoalescingTestCase::DoRun (void)
+{
+  const ecs::ecsClusterApp::WireFormat formats[] = {ecs::ecsClusterApp::WIRE_PROTOBUF,
+                                                     ecs::ecsClusterApp::WIRE_BINARY};
+  for (ecs::ecsClusterApp::WireFormat format : formats)
+    {
+      Ptr<ecs::ecsClusterApp> app = CreateObject<ecs::ecsClusterApp> ();
+      Access::Format (*app) = format;
+      Access::Address (*app) = HELLO_SENDER;
+      Access::HelloTimeout (*app) = MilliSeconds (1000);
+      Access::CoalesceWindow (*app) = MilliSeconds (10);
+
+      // the claim opens the frame, the hello and its two replies join it
+      Access::QueueMessage (*app, Access::BROADCAST, Access::GenerateClusterHeadClaim (*app));
+      Access::Piggybacked (*app).push_back (std::make_pair (0x0a010007, Access::GenerateStatus (*app, 2, 0x0a010007)));
+      Access::Piggybacked (*app).push_back (std::make_pair (0x0a010008, Access::GenerateStatus (*app, 3, 0x0a010008)));
+      Access::SendPing (*app, 4);
+      NS_TEST_ASSERT_MSG_EQ (Access::Outbound (*app).size (), 1, "everything went into one frame");
+      NS_TEST_ASSERT_MSG_EQ (Access::Piggybacked (*app).size (), 0, "the replies left with the hello");
+
+      std::vector<ecs::EcsHeader> frame;
+      NS_TEST_ASSERT_MSG_EQ (Access::DecodeFrame (*app, Access::Outbound (*app)[0].second->Copy (), frame), true, "frame should decode");
+      NS_TEST_ASSERT_MSG_EQ (frame.size (), 4, "every message is read");
+      const ecs::EcsHeader::Type types[] = {ecs::EcsHeader::CLAIM, ecs::EcsHeader::PING,
+                                            ecs::EcsHeader::STATUS, ecs::EcsHeader::STATUS};
+      // ids are handed out in the order the messages were generated
+      const uint32_t sequences[] = {1, 4, 2, 3};
+      for (size_t i = 0; i < frame.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (frame[i].GetType (), types[i], "message type in frame order");
+          NS_TEST_ASSERT_MSG_EQ (frame[i].GetId (), ecs::MakeMessageId (HELLO_SENDER, sequences[i]), "message id");
+        }
+      NS_TEST_ASSERT_MSG_EQ (frame[2].GetRecipient (), 0x0a010007, "first reply");
+      NS_TEST_ASSERT_MSG_EQ (frame[3].GetRecipient (), 0x0a010008, "second reply");
+      Simulator::Destroy ();
+    }
+}
+
+// Replies waiting for a hello go out on their own when that hello is
+// suppressed or moved past the piggyback delay, and ride on a hello that is
+// sent because neighbours would drop this node otherwise
+//
+class PiggybackTestCase : public TestCase
+{
+public:
+  PiggybackTestCase ();
+
+private:
+  virtual void DoRun (void);
+  Ptr<ecs::ecsClusterApp> WaitingApp (void);
+  void CheckFlushed (Ptr<ecs::ecsClusterApp> app, std::string when);
+};
+
+PiggybackTestCase::PiggybackTestCase ()
+  : TestCase ("Piggybacked replies are not stranded")
+{
+}
+
+static const uint32_t PIGGYBACK_RECIPIENT = 0x0a010007;
+
+// an app in Trickle mode holding one reply for the next hello
+Ptr<ecs::ecsClusterApp>
+PiggybackTestCase::WaitingApp (void)
+{
+  Ptr<ecs::ecsClusterApp> app = CreateObject<ecs::ecsClusterApp> ();
+  Access::Address (*app) = HELLO_SENDER;
+  Access::HelloTimeout (*app) = MilliSeconds (1000);
+  Access::CoalesceWindow (*app) = MilliSeconds (10);
+  Access::PiggybackDelay (*app) = MilliSeconds (100);
+  Access::HelloMode (*app) = ecs::ecsClusterApp::HELLO_TRICKLE;
+  Access::Trickle (*app) = ecs::TrickleTimer (Seconds (1), Seconds (16), 1);
+  Access::Trickle (*app).StartInterval (0.5);
+  Access::HelloCoveredUntil (*app) = Seconds (100);
+  Access::Piggybacked (*app).push_back (std::make_pair (PIGGYBACK_RECIPIENT, Access::GenerateStatus (*app, 2, PIGGYBACK_RECIPIENT)));
+  return app;
+}
+
+void
+PiggybackTestCase::CheckFlushed (Ptr<ecs::ecsClusterApp> app, std::string when)
+{
+  NS_TEST_ASSERT_MSG_EQ (Access::Piggybacked (*app).size (), 0, "reply still waiting " + when);
+  NS_TEST_ASSERT_MSG_EQ (Access::Outbound (*app).size (), 1, "reply should be queued " + when);
+  NS_TEST_ASSERT_MSG_EQ (Access::Outbound (*app)[0].first, PIGGYBACK_RECIPIENT, "reply goes to its node " + when);
+
+  std::vector<ecs::EcsHeader> frame;
+  Access::Address (*app) = PIGGYBACK_RECIPIENT;
+  NS_TEST_ASSERT_MSG_EQ (Access::DecodeFrame (*app, Access::Outbound (*app)[0].second->Copy (), frame), true, "reply should decode " + when);
+  NS_TEST_ASSERT_MSG_EQ (frame.size (), 1, "only the reply " + when);
+  NS_TEST_ASSERT_MSG_EQ (frame[0].GetType (), ecs::EcsHeader::STATUS, "reply type " + when);
+}
+
+void
+PiggybackTestCase::DoRun (void)
+{
+  // a copy heard in the interval suppresses the hello
+  Ptr<ecs::ecsClusterApp> app = WaitingApp ();
+  Access::Trickle (*app).Heard ();
+  Access::TrickleHello (app);
+  CheckFlushed (app, "after a suppressed hello");
+  Simulator::Destroy ();
+
+  // neighbours would drop this node before the next interval ends, so the
+  // hello goes out anyway and carries the reply
+  app = WaitingApp ();
+  Access::HelloCoveredUntil (*app) = Seconds (1);
+  Access::Trickle (*app).Heard ();
+  Access::TrickleHello (app);
+  NS_TEST_ASSERT_MSG_EQ (Access::Piggybacked (*app).size (), 0, "reply rides on the hello");
+  NS_TEST_ASSERT_MSG_EQ (Access::Outbound (*app).size (), 1, "only the hello is queued");
+  NS_TEST_ASSERT_MSG_EQ (Access::Outbound (*app)[0].first, Access::BROADCAST, "the hello is broadcast");
+  std::vector<ecs::EcsHeader> frame;
+  Access::Address (*app) = PIGGYBACK_RECIPIENT;
+  NS_TEST_ASSERT_MSG_EQ (Access::DecodeFrame (*app, Access::Outbound (*app)[0].second->Copy (), frame), true, "hello should decode");
+  NS_TEST_ASSERT_MSG_EQ (frame.size (), 2, "the hello and the reply");
+  NS_TEST_ASSERT_MSG_EQ (frame[0].GetType (), ecs::EcsHeader::PING, "hello first");
+  NS_TEST_ASSERT_MSG_EQ (frame[1].GetType (), ecs::EcsHeader::STATUS, "then the reply");
+  Simulator::Destroy ();
+
+  // the hello was moved well past the delay
+  app = WaitingApp ();
+  Access::HelloEvent (*app) = Simulator::Schedule (Seconds (5), &Access::TrickleHello, app);
+  Access::CheckPiggybackDeadline (*app);
+  CheckFlushed (app, "after the hello moved");
+  Simulator::Destroy ();
+}
+
+// A cluster head with a small table and a gateway to another cluster
+// resigns to a guest, and a head that has resigned has no members left
+//
+class ResignTestCase : public TestCase
+{
+public:
+  ResignTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ResignTestCase::ResignTestCase ()
+  : TestCase ("A resigning cluster head drops its members")
+{
+}
+
+void
+ResignTestCase::DoRun (void)
+{
+  const uint32_t member = 0x0a010007;
+  const uint32_t gateway = 0x0a010008;
+  const uint32_t onlyHead[] = {HELLO_SENDER};
+  const uint32_t twoHeads[] = {HELLO_HEAD, HELLO_SENDER};
+
+  Ptr<ecs::ecsClusterApp> app = CreateObject<ecs::ecsClusterApp> ();
+  Access::Address (*app) = HELLO_SENDER;
+  Access::CoalesceWindow (*app) = MilliSeconds (10);
+  Access::SendClusterHeadClaim (*app);
+  Access::Table (*app).Upsert ({member, ecs::ecsClusterApp::Node_Status::CLUSTER_MEMBER, HELLO_SENDER, 0, 0, 1000});
+  Access::Table (*app).Upsert ({gateway, ecs::ecsClusterApp::Node_Status::CLUSTER_GATEWAY, HELLO_SENDER, 0, 0, 1000});
+  Access::Members (*app).Update (member, HELLO_SENDER, onlyHead, 1, 0, 1000);
+  Access::Members (*app).Update (gateway, HELLO_SENDER, twoHeads, 2, 0, 1000);
+  NS_TEST_ASSERT_MSG_EQ (Access::Members (*app).GetSize (), 2, "the head has two members");
+
+  Access::CheckCHShouldResign (*app);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)app->GetStatus (), (uint32_t)ecs::ecsClusterApp::Node_Status::CLUSTER_GUEST,
+                         "the head resigns through the gateway");
+  NS_TEST_ASSERT_MSG_EQ (Access::Members (*app).GetSize (), 0, "a guest has no members");
+
+  // the claim and the resign share the broadcast frame
+  NS_TEST_ASSERT_MSG_EQ (Access::Outbound (*app).size (), 1, "one broadcast frame");
+  NS_TEST_ASSERT_MSG_EQ (Access::Outbound (*app)[0].first, Access::BROADCAST, "the resign is broadcast");
+  std::vector<ecs::EcsHeader> frame;
+  NS_TEST_ASSERT_MSG_EQ (Access::DecodeFrame (*app, Access::Outbound (*app)[0].second->Copy (), frame), true,
+                         "frame should decode");
+  NS_TEST_ASSERT_MSG_EQ (frame.size (), 2, "the claim and the resign");
+  NS_TEST_ASSERT_MSG_EQ (frame[1].GetType (), ecs::EcsHeader::RESIGN, "then the resign");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)frame[1].GetNodeStatus (), 5, "sent with the guest status");
+  Simulator::Destroy ();
+}
+
+// Trickle doubles the interval while it stays quiet, suppresses the send
+// after k consistent copies and falls back to the minimum on an inconsistency
+//
+class TrickleTimerTestCase : public TestCase
+{
+public:
+  TrickleTimerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TrickleTimerTestCase::TrickleTimerTestCase ()
+  : TestCase ("Trickle timer doubles, suppresses and resets")
+{
+}
+
+void
+TrickleTimerTestCase::DoRun (void)
+{
+  ecs::TrickleTimer trickle (Seconds (1), Seconds (8), 2);
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetInterval (), Seconds (1), "should start at Imin");
+  NS_TEST_ASSERT_MSG_EQ (trickle.Reset (), false, "a reset at Imin keeps the interval");
+
+  // t falls in the second half of the interval
+  NS_TEST_ASSERT_MSG_EQ (trickle.StartInterval (0), Seconds (0.5), "earliest send");
+  NS_TEST_ASSERT_MSG_EQ ((trickle.StartInterval (0.999) < Seconds (1)), true, "latest send");
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetNextInterval (), Seconds (2), "next interval doubles");
+
+  for (int i = 0; i < 4; i++)
+    {
+      trickle.EndInterval ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetInterval (), Seconds (8), "should not pass Imax");
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetNextInterval (), Seconds (8), "next interval stays at Imax");
+
+  trickle.StartInterval (0.5);
+  NS_TEST_ASSERT_MSG_EQ (trickle.ShouldSend (), true, "nothing heard yet");
+  trickle.Heard ();
+  NS_TEST_ASSERT_MSG_EQ (trickle.ShouldSend (), true, "one copy is below k");
+  trickle.Heard ();
+  NS_TEST_ASSERT_MSG_EQ (trickle.ShouldSend (), false, "k copies suppress the send");
+  trickle.StartInterval (0.5);
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetCounter (), 0u, "a new interval clears the counter");
+
+  NS_TEST_ASSERT_MSG_EQ (trickle.Reset (), true, "an inconsistency above Imin resets");
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetInterval (), Seconds (1), "back to Imin");
+
+  // k of 0 never suppresses
+  ecs::TrickleTimer always (Seconds (1), Seconds (8), 0);
+  always.StartInterval (0);
+  for (int i = 0; i < 100; i++)
+    {
+      always.Heard ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (always.ShouldSend (), true, "k of 0 should always send");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +1766,26 @@ EcsClusteringTestSuite::EcsClusteringTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new EcsClusteringTestCase1, TestCase::QUICK);
+  AddTestCase (new TableParserTestCase, TestCase::QUICK);
+#ifdef ECS_ROUTE_TABLE_ACCESS
+  AddTestCase (new RouteReaderTestCase, TestCase::QUICK);
+#endif
+  AddTestCase (new RouteChangeTestCase, TestCase::QUICK);
+  AddTestCase (new ChangeDegreeTestCase, TestCase::QUICK);
+  AddTestCase (new TableDeltaTestCase, TestCase::QUICK);
+  AddTestCase (new AdaptiveIntervalTestCase, TestCase::QUICK);
+  AddTestCase (new NeighborhoodGraphTestCase, TestCase::QUICK);
+  AddTestCase (new NeighborOracleTestCase, TestCase::QUICK);
+  AddTestCase (new InformationTableTestCase, TestCase::QUICK);
+  AddTestCase (new ClusterMembershipTestCase, TestCase::QUICK);
+  AddTestCase (new ReplayWindowTestCase, TestCase::QUICK);
+  AddTestCase (new DuplicateFilterTestCase, TestCase::QUICK);
+  AddTestCase (new EcsHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new HelloTemplateTestCase, TestCase::QUICK);
+  AddTestCase (new CoalescingTestCase, TestCase::QUICK);
+  AddTestCase (new PiggybackTestCase, TestCase::QUICK);
+  AddTestCase (new ResignTestCase, TestCase::QUICK);
+  AddTestCase (new TrickleTimerTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite